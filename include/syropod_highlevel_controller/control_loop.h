@@ -0,0 +1,57 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_CONTROL_LOOP_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_CONTROL_LOOP_H
+
+#include "state_controller.h"
+
+#include <atomic>
+
+#define ACQUISTION_TIME 10            ///< Max time controller will wait to acquire intitial joint states (seconds)
+#define NANOSECONDS_PER_SECOND 1.0e9  ///< Conversion factor between seconds and nanoseconds
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Sets the rosconsole logger level as defined by the console verbosity parameter. The level applies to every logger
+/// of the process, so when called from the nodelet it also changes the verbosity of the entire nodelet manager.
+/// @param[in] params The parameter data structure
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void configureConsoleVerbosity(const Parameters &params);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Applies real-time scheduling priority and CPU affinity to the calling thread as defined by parameters. Failure to
+/// apply either (e.g. due to insufficient privileges) is not fatal and the thread continues with default scheduling.
+/// @param[in] params The parameter data structure
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void configureControlThread(const Parameters &params);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Control loop. Each cycle passes buffered inputs to the state controller callbacks, calls the state controller loop,
+/// publishes desired joint states and captures telemetry (published by a separate thread), then sleeps until the
+/// absolute deadline of the next cycle. Deadlines are advanced by a fixed period so that execution time does not
+/// accumulate as drift. When a deadline is missed the schedule restarts from the current time rather than running
+/// several cycles back to back to catch up.
+/// @param[in] state Pointer to the state controller
+/// @param[in] stop Flag which ends the loop when set (in addition to ros shutdown or a fatal controller error)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void runControlLoop(StateController *state, const std::atomic<bool> &stop);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Runs the state controller from construction until ros shutdown (or stop), as shared by the standalone node and the
+/// nodelet. Waits to acquire initial joint states, then waits for the start button press before initialising the
+/// controller and model and running the control loop. Must be called from the thread dedicated to control, with
+/// subscribed topics received by a separate spinner thread. Also returns on a fatal error of the state controller,
+/// leaving the caller to decide whether ros is shut down (i.e. the standalone node but not the nodelet manager).
+/// @param[in] state Pointer to the state controller
+/// @param[in] stop Flag which ends the controller when set (in addition to ros shutdown)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void runController(StateController *state, const std::atomic<bool> &stop);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_CONTROL_LOOP_H
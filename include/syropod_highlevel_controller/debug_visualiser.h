@@ -24,7 +24,8 @@ class DebugVisualiser
 {
 public:
   /// Constructor for debug output class. Sets up publishers for the visualisation markers and initialises odometry.
-  DebugVisualiser(void);
+  /// @param[in] node_handle Node handle used to advertise visualisation topics, null if running headless
+  DebugVisualiser(std::shared_ptr<ros::NodeHandle> node_handle);
 
   /// Modifier for the time_delta_ member variable.
   inline void setTimeDelta(const double &time_delta) { time_delta_ = time_delta; };
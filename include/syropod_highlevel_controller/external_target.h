@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_EXTERNAL_TARGET_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_EXTERNAL_TARGET_H
+
+#include "standard_includes.h"
+#include "pose.h"
+
+#include <atomic>
+#include <mutex>
+
+#define MAX_FRAME_ID_COUNT 64  ///< Maximum number of unique frame ids which may be interned
+#define UNDEFINED_FRAME_ID -1  ///< Interned frame id of an undefined or unregistered frame
+#define ODOM_IDEAL_FRAME_ID 0  ///< Interned frame id of the 'odom_ideal' frame (registered on start up)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Returns the interned frame id of a frame name, registering the frame name if not previously registered. Registered
+/// frame names are never modified or reallocated, hence may be safely read from any thread.
+/// @param[in] frame_name The frame name
+/// @return The interned frame id of the frame name (UNDEFINED_FRAME_ID if the frame name is empty or the maximum number
+/// of frame names are registered)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int internFrameID(const std::string &frame_name);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Returns the frame name of an interned frame id.
+/// @param[in] frame_id The interned frame id
+/// @return The frame name (empty if the frame id is undefined)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+const std::string &getFrameName(const int &frame_id);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Object containing parameters which define an externally set target tip pose.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct ExternalTarget
+{
+  Pose pose_;                               ///< The target tip pose
+  double swing_clearance_;                  ///< The height of the swing trajectory clearance normal to walk plane
+  int frame_id_ = UNDEFINED_FRAME_ID;       ///< The interned id of the target tip pose reference frame
+  ros::Time time_;                          ///< The ros time of the request for the target tip pose
+  Pose transform_;                          ///< The transform between reference frames at request and current time
+  Pose request_transform_;                  ///< Cached pose of odom_ideal in the reference frame at time of request
+  bool request_transform_defined_ = false;  ///< Flag denoting if the request transform has been cached
+  bool defined_ = false;                    ///< Flag denoting if external target object has been defined
+  bool planned_ = false;                    ///< Flag denoting if external target was generated by in-process planner
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_EXTERNAL_TARGET_H
@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_FOOTSTEP_PLANNER_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_FOOTSTEP_PLANNER_H
+
+#include "standard_includes.h"
+#include "parameters_and_states.h"
+#include "pose.h"
+#include "model.h"
+#include "walk_controller.h"
+
+#define FOOTSTEP_SEARCH_CELLS 3      ///< Number of grid cells searched either side of nominal footstep along each axis
+#define FOOTSTEP_OFFSET_COST 0.05    ///< Cost per squared cell of offsetting footstep from nominal touchdown position
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// This class plans the next N touchdown positions of each leg whilst walking. Nominal touchdown positions are
+/// predicted from the current body velocity and searched about on a local grid for the lowest cost position which
+/// keeps the following stance period within the walkspace and the tip within the leg workspace. Costs combine the
+/// offset from the nominal position with a terrain cost derived from the step height of the walk controller's terrain
+/// height map at the candidate position. Plans are extended incrementally as each leg enters swing and the next
+/// footstep is given to the LegStepper object as an external target.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class FootstepPlanner
+{
+public:
+  /// Constructor for the footstep planner.
+  /// @param[in] walker A pointer to the walk controller
+  /// @param[in] params A reference to the parameter data structure
+  FootstepPlanner(std::shared_ptr<WalkController> walker, const Parameters &params);
+
+  /// Clears planned footsteps of all legs.
+  inline void clearFootsteps(void) { footsteps_.clear(); };
+
+  /// Updates the plan of the input leg as it enters swing period and sets the next footstep as the external target of
+  /// the leg stepper (unless an externally requested target is already defined). Previously planned footsteps are
+  /// retained unless the nominal touchdown position has moved beyond the search grid, so typically only the footstep
+  /// at the end of the planning horizon is newly searched.
+  /// @param[in] leg A pointer to the leg object entering swing period
+  void planFootsteps(std::shared_ptr<Leg> leg);
+
+  /// Returns the terrain cost of stepping at the input position, proportional to the step height of the mapped
+  /// terrain relative to the input position.
+  /// @param[in] position The nominal touchdown position on the walk plane in the odom_ideal frame
+  /// @return The terrain cost or zero if the terrain height at the position is unknown
+  double getTerrainCost(const Eigen::Vector3d &position);
+
+private:
+  /// Generates the lowest cost footstep about a nominal touchdown position.
+  /// @param[in] leg A pointer to the leg object
+  /// @param[in] touchdown_pose The predicted pose of the walk plane in the odom_ideal frame at touchdown
+  /// @param[in] walkspace The walkspace map of radii about the default tip position
+  /// @return The planned touchdown position in the odom_ideal frame
+  Eigen::Vector3d generateFootstep(std::shared_ptr<Leg> leg, const Pose &touchdown_pose, const LimitMap &walkspace);
+
+  /// Returns true if the input offset from default tip position lies within the walkspace.
+  /// @param[in] offset The offset from default tip position
+  /// @param[in] walkspace The walkspace map of radii about the default tip position
+  /// @return Flag denoting if the offset lies within the walkspace
+  bool isWithinWalkspace(const Eigen::Vector3d &offset, const LimitMap &walkspace);
+
+  /// Generates the predicted pose of the walk plane in the odom_ideal frame after a given time.
+  /// @param[in] time_period The time from present
+  /// @return The predicted pose of the walk plane
+  Pose predictWalkPlanePose(const double &time_period);
+
+  std::shared_ptr<WalkController> walker_; ///< Pointer to walk controller object
+  const Parameters &params_;               ///< Reference to parameter data structure for storing parameter variables
+
+  std::map<int, std::deque<Eigen::Vector3d>> footsteps_; ///< Planned footsteps (odom_ideal frame) of each leg
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_FOOTSTEP_PLANNER_H
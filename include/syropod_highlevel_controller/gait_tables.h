@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_GAIT_TABLES_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_GAIT_TABLES_H
+
+#include "standard_includes.h"
+
+#define MAX_LEG_COUNT 8 ///< Maximum number of legs supported by gait definitions
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Definition of a gait as per gait parameters (config/gait.yaml), with offset multipliers indexed by leg id number.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct GaitDescriptor
+{
+  int stance_phase;                     ///< The ratio of the entire step cycle which is in 'stance'
+  int swing_phase;                      ///< The ratio of the entire step cycle which is in 'swing'
+  int phase_offset;                     ///< The phase offset between step cycles of successive legs
+  int leg_count;                        ///< The number of legs for which offset multipliers are defined
+  int offset_multiplier[MAX_LEG_COUNT]; ///< The leg dependent multiplier for the step cycle offset
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Step cycle timing of a gait in iterations of the base step cycle, indexed by leg id number. Timing for an actual
+/// step cycle is found by multiplying each value by the normaliser (step period / base step period).
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct GaitTable
+{
+  int base_step_period;             ///< The period of the base step cycle
+  int stance_end;                   ///< The phase at which the stance period ends
+  int swing_start;                  ///< The phase at which the swing period starts
+  int swing_end;                    ///< The phase at which the swing period ends
+  int stance_start;                 ///< The phase at which the stance period starts
+  int leg_count;                    ///< The number of legs for which phase offsets are defined
+  int phase_offsets[MAX_LEG_COUNT]; ///< The phase offset of the step cycle of each leg
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Generates step cycle timing from a gait definition. Phase offsets are generated for at most MAX_LEG_COUNT legs, such
+/// that timing of a gait defined for more legs is rejected by isValidGait.
+/// @param[in] gait The gait definition
+/// @return The step cycle timing of the gait
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+constexpr GaitTable generateGaitTable(const GaitDescriptor &gait)
+{
+  GaitTable table = {};
+  table.base_step_period = gait.stance_phase + gait.swing_phase;
+  table.stance_end = gait.stance_phase / 2;
+  table.swing_start = table.stance_end;
+  table.swing_end = table.swing_start + gait.swing_phase;
+  table.stance_start = table.swing_end;
+  table.leg_count = gait.leg_count;
+  for (int i = 0; i < gait.leg_count && i < MAX_LEG_COUNT && table.base_step_period > 0; ++i)
+  {
+    table.phase_offsets[i] = (gait.phase_offset * gait.offset_multiplier[i]) % table.base_step_period;
+  }
+  return table;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Compares two gait definitions.
+/// @param[in] a The first gait definition
+/// @param[in] b The second gait definition
+/// @return Flag denoting if the gait definitions are identical
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+constexpr bool isEqualGait(const GaitDescriptor &a, const GaitDescriptor &b)
+{
+  bool equal = (a.stance_phase == b.stance_phase && a.swing_phase == b.swing_phase &&
+                a.phase_offset == b.phase_offset && a.leg_count == b.leg_count);
+  for (int i = 0; i < a.leg_count && equal; ++i)
+  {
+    equal = (a.offset_multiplier[i] == b.offset_multiplier[i]);
+  }
+  return equal;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Checks validity of step cycle timing of a gait. Valid gaits have non-zero stance and swing periods, a reference leg
+/// with zero phase offset (used by auto posing) and at no phase have more than half of the legs in swing.
+/// @param[in] table The step cycle timing of the gait
+/// @return Flag denoting if the gait is valid
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+constexpr bool isValidGait(const GaitTable &table)
+{
+  if (table.stance_end < 0 || table.swing_end <= table.swing_start || table.stance_start >= table.base_step_period ||
+      table.leg_count < 1 || table.leg_count > MAX_LEG_COUNT)
+  {
+    return false;
+  }
+
+  bool reference_leg_defined = false;
+  for (int i = 0; i < table.leg_count; ++i)
+  {
+    reference_leg_defined = reference_leg_defined || table.phase_offsets[i] == 0;
+  }
+
+  for (int phase = 0; phase < table.base_step_period; ++phase)
+  {
+    int swinging_legs = 0;
+    for (int i = 0; i < table.leg_count; ++i)
+    {
+      int leg_phase = (phase + table.phase_offsets[i]) % table.base_step_period;
+      swinging_legs += (leg_phase >= table.swing_start && leg_phase < table.swing_end) ? 1 : 0;
+    }
+    if (2 * swinging_legs > table.leg_count)
+    {
+      return false;
+    }
+  }
+  return reference_leg_defined;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Built-in gaits as defined in config/gait.yaml for legs [AR, BR, CR, CL, BL, AL], in order of GaitDesignation.
+constexpr GaitDescriptor BUILTIN_GAITS[] = {
+  { 10, 2, 2, 6, { 2, 3, 4, 1, 0, 5 } }, // Wave gait
+  { 2, 1, 1, 6, { 1, 2, 0, 1, 2, 0 } },  // Amble gait
+  { 4, 2, 1, 6, { 2, 0, 4, 1, 3, 5 } },  // Ripple gait
+  { 2, 2, 2, 6, { 0, 1, 0, 1, 0, 1 } },  // Tripod gait
+};
+
+/// Step cycle timing of built-in gaits, generated at compile time.
+constexpr GaitTable BUILTIN_GAIT_TABLES[] = {
+  generateGaitTable(BUILTIN_GAITS[0]),
+  generateGaitTable(BUILTIN_GAITS[1]),
+  generateGaitTable(BUILTIN_GAITS[2]),
+  generateGaitTable(BUILTIN_GAITS[3]),
+};
+
+constexpr int BUILTIN_GAIT_COUNT = sizeof(BUILTIN_GAITS) / sizeof(GaitDescriptor);
+static_assert(BUILTIN_GAIT_COUNT == sizeof(BUILTIN_GAIT_TABLES) / sizeof(GaitTable), "Missing built-in gait table");
+static_assert(isValidGait(BUILTIN_GAIT_TABLES[0]), "Invalid built-in wave gait");
+static_assert(isValidGait(BUILTIN_GAIT_TABLES[1]), "Invalid built-in amble gait");
+static_assert(isValidGait(BUILTIN_GAIT_TABLES[2]), "Invalid built-in ripple gait");
+static_assert(isValidGait(BUILTIN_GAIT_TABLES[3]), "Invalid built-in tripod gait");
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_GAIT_TABLES_H
@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_INPUT_BUFFER_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_INPUT_BUFFER_H
+
+#include "standard_includes.h"
+
+#include <atomic>
+#include <functional>
+#include <boost/shared_ptr.hpp>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Base class of buffers which hand over subscribed messages from a ros spinner thread (single producer) to the control
+/// thread (single consumer) without locking. Messages are held by shared pointer so are never copied or deallocated by
+/// the control thread.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class InputBuffer
+{
+public:
+  /// Destructor for the input buffer.
+  virtual ~InputBuffer(void) {};
+
+  /// Passes each message posted since the previous call to the message handler, in order of posting. Must only be
+  /// called from the consumer thread.
+  virtual void process(void) = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Input buffer holding only the latest posted message (triple buffer). Used for topics which publish state (e.g. user
+/// inputs) where only the latest message is of interest and must never be dropped.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename M>
+class LatestInputBuffer : public InputBuffer
+{
+public:
+  typedef boost::shared_ptr<const M> MessagePtr; ///< Shared pointer to message
+
+  /// Constructor for the latest input buffer.
+  /// @param[in] handler The message handler called by the consumer thread for the latest message
+  LatestInputBuffer(const std::function<void(const M&)> &handler)
+    : handler_(handler)
+    , middle_(1)
+  {
+  };
+
+  /// Posts a message, replacing any message not yet processed. Must only be called from the producer thread.
+  /// @param[in] message Shared pointer to the message
+  void post(const MessagePtr &message)
+  {
+    slots_[back_] = message;
+    back_ = middle_.exchange(back_ | FRESH_FLAG, std::memory_order_acq_rel) & INDEX_MASK;
+  };
+
+  /// Passes the latest message to the message handler if posted since the previous call.
+  void process(void)
+  {
+    if (middle_.load(std::memory_order_relaxed) & FRESH_FLAG)
+    {
+      front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+      handler_(*slots_[front_]);
+    }
+  };
+
+private:
+  static const int INDEX_MASK = 0x3; ///< Mask of slot index within middle slot state
+  static const int FRESH_FLAG = 0x4; ///< Flag within middle slot state denoting an unprocessed message
+
+  std::function<void(const M&)> handler_; ///< Message handler
+  MessagePtr slots_[3];                   ///< Slots holding messages, each owned by producer, consumer or neither
+  int back_ = 0;                          ///< Index of slot owned by producer
+  int front_ = 2;                         ///< Index of slot owned by consumer
+  std::atomic<int> middle_;               ///< Index of slot owned by neither and fresh flag
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Input buffer holding a bounded queue of posted messages (ring buffer). Used for topics where every message carries
+/// distinct data (e.g. joint states published in parts by multiple drivers). Messages posted whilst full are dropped.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename M>
+class QueuedInputBuffer : public InputBuffer
+{
+public:
+  typedef boost::shared_ptr<const M> MessagePtr; ///< Shared pointer to message
+
+  /// Constructor for the queued input buffer.
+  /// @param[in] capacity The maximum number of messages held
+  /// @param[in] handler The message handler called by the consumer thread for each message
+  QueuedInputBuffer(const int &capacity, const std::function<void(const M&)> &handler)
+    : handler_(handler)
+    , slots_(capacity + 1)
+    , head_(0)
+    , tail_(0)
+  {
+  };
+
+  /// Posts a message to the end of the queue. Must only be called from the producer thread.
+  /// @param[in] message Shared pointer to the message
+  void post(const MessagePtr &message)
+  {
+    int head = head_.load(std::memory_order_relaxed);
+    int next = (head + 1) % static_cast<int>(slots_.size());
+    if (next == tail_.load(std::memory_order_acquire))
+    {
+      ROS_WARN_THROTTLE(THROTTLE_PERIOD, "\n[SHC] Input buffer full, dropping message. Control loop is overrunning.\n");
+      return;
+    }
+    slots_[head] = message;
+    head_.store(next, std::memory_order_release);
+  };
+
+  /// Passes each queued message to the message handler in order of posting.
+  void process(void)
+  {
+    int tail = tail_.load(std::memory_order_relaxed);
+    int head = head_.load(std::memory_order_acquire);
+    while (tail != head)
+    {
+      handler_(*slots_[tail]);
+      tail = (tail + 1) % static_cast<int>(slots_.size());
+      tail_.store(tail, std::memory_order_release);
+    }
+  };
+
+private:
+  std::function<void(const M&)> handler_; ///< Message handler
+  std::vector<MessagePtr> slots_;         ///< Ring of slots holding messages (one slot always empty)
+  std::atomic<int> head_;                 ///< Index of next slot to be written by producer
+  std::atomic<int> tail_;                 ///< Index of next slot to be read by consumer
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_INPUT_BUFFER_H
@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_LOOP_PROFILER_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_LOOP_PROFILER_H
+
+#include "standard_includes.h"
+#include "parameters_and_states.h"
+
+#include <atomic>
+
+#define TIMING_BUCKET_COUNT 96        ///< Number of logarithmically spaced duration buckets of each stage histogram
+#define TIMING_BUCKETS_PER_OCTAVE 4   ///< Number of histogram buckets per doubling of duration
+#define TIMING_BUCKET_MINIMUM 1.0e-6  ///< Upper bound of the first histogram bucket (seconds)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Returns a short name for a timed stage of the control loop, as used in diagnostics.
+/// @param[in] stage The timed stage
+/// @return The name of the timed stage
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+std::string getUpdateStageName(const UpdateStage &stage);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Object containing timing statistics of a stage over a window of control loop cycles. Percentiles are resolved to the
+/// upper bound of the histogram bucket containing the percentile (within ~19% of the true value).
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct StageStatistics
+{
+  unsigned long count = 0;          ///< Number of timed executions of the stage within the window
+  unsigned long overrun_count = 0;  ///< Number of executions exceeding the control loop period within the window
+  double p50 = 0.0;                 ///< Median duration (seconds)
+  double p99 = 0.0;                 ///< 99th percentile duration (seconds)
+  double max = 0.0;                 ///< Maximum duration (seconds)
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// This class records durations of a single stage into a histogram of logarithmically spaced buckets. Counts are
+/// cumulative and only ever incremented by the recording thread, whilst the collecting thread differences counts
+/// against those of the previous collection, hence neither thread blocks or resets state owned by the other.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class StageHistogram
+{
+public:
+  /// Constructor for the stage histogram.
+  StageHistogram(void);
+
+  /// Records a duration. Must only be called from a single recording thread.
+  /// @param[in] duration The duration (seconds)
+  /// @param[in] overrun Flag denoting if the duration exceeded the control loop period
+  void record(const double &duration, const bool &overrun);
+
+  /// Generates statistics of durations recorded since the previous collection. Must only be called from a single
+  /// collecting thread.
+  /// @return The timing statistics of the window since the previous collection
+  StageStatistics collect(void);
+
+private:
+  std::atomic<unsigned long> bucket_counts_[TIMING_BUCKET_COUNT]; ///< Cumulative duration count of each bucket
+  std::atomic<unsigned long> overrun_count_;                      ///< Cumulative overrun count
+  std::atomic<long> max_nanoseconds_;                             ///< Maximum duration since the previous collection
+
+  unsigned long collected_bucket_counts_[TIMING_BUCKET_COUNT] = {}; ///< Bucket counts at previous collection
+  unsigned long collected_overrun_count_ = 0;                       ///< Overrun count at previous collection
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// This class holds timing histograms and the latest duration of each stage of the control loop. Recording is skipped
+/// entirely whilst disabled, such that timers cost a single branch.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class LoopProfiler
+{
+public:
+  /// Constructor for the loop profiler.
+  /// @param[in] enabled Flag denoting if stage timing is recorded
+  /// @param[in] period The control loop period against which overruns are counted (seconds)
+  LoopProfiler(const bool &enabled, const double &period);
+
+  /// Accessor for whether stage timing is recorded.
+  /// @return Flag denoting if stage timing is recorded
+  inline bool isEnabled(void) { return enabled_; };
+
+  /// Accessor for the latest duration of each stage. Must only be called from the recording thread.
+  /// @return Array of durations (seconds) indexed by UpdateStage, zero for stages not executed since the last clear
+  inline std::array<double, UPDATE_STAGE_COUNT> getLatestDurations(void) { return latest_durations_; };
+
+  /// Clears the latest duration of each stage.
+  inline void clearLatestDurations(void) { latest_durations_.fill(0.0); };
+
+  /// Records a duration of a stage.
+  /// @param[in] stage The timed stage
+  /// @param[in] duration The duration (seconds)
+  void record(const UpdateStage &stage, const double &duration);
+
+  /// Generates statistics of a stage since its previous collection.
+  /// @param[in] stage The timed stage
+  /// @return The timing statistics of the stage
+  inline StageStatistics collect(const UpdateStage &stage) { return histograms_[stage].collect(); };
+
+private:
+  bool enabled_;                                                 ///< Flag denoting if stage timing is recorded
+  double period_;                                                ///< The control loop period (seconds)
+  StageHistogram histograms_[UPDATE_STAGE_COUNT];                ///< Timing histogram of each stage
+  std::array<double, UPDATE_STAGE_COUNT> latest_durations_ = {}; ///< Latest duration of each stage (seconds)
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Timer which records the duration of the enclosing scope as a stage of the loop profiler on destruction.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class ScopedStageTimer
+{
+public:
+  /// Constructor for the scoped stage timer. Starts timing if the profiler is enabled.
+  /// @param[in] profiler The loop profiler
+  /// @param[in] stage The timed stage
+  ScopedStageTimer(LoopProfiler &profiler, const UpdateStage &stage)
+    : profiler_(profiler.isEnabled() ? &profiler : NULL)
+    , stage_(stage)
+  {
+    if (profiler_)
+    {
+      start_ = std::chrono::steady_clock::now();
+    }
+  };
+
+  /// Destructor for the scoped stage timer. Records the duration since construction.
+  ~ScopedStageTimer(void)
+  {
+    if (profiler_)
+    {
+      profiler_->record(stage_, std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count());
+    }
+  };
+
+private:
+  LoopProfiler* profiler_;                      ///< Pointer to the loop profiler, null if disabled
+  UpdateStage stage_;                           ///< The timed stage
+  std::chrono::steady_clock::time_point start_; ///< Time of construction
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_LOOP_PROFILER_H
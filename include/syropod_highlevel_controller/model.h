@@ -12,6 +12,7 @@
 #include "standard_includes.h"
 #include "parameters_and_states.h"
 #include "pose.h"
+#include "worker_pool.h"
 #include "syropod_highlevel_controller/LegState.h"
 
 #define IK_TOLERANCE 0.005          ///< Tolerance between desired & resultant tip position from IK/FK(m)
@@ -91,6 +92,14 @@ public:
   /// @return The time delta value which define the period of the ros cycle
   inline double getTimeDelta(void) { return time_delta_; }
 
+  /// Accessor for the flag denoting if an unrecoverable error has occurred in the model or its controllers.
+  /// @return Flag denoting if an unrecoverable error has occurred
+  inline bool hasFatalError(void) { return fatal_error_; };
+
+  /// Flags an unrecoverable error of the model or its controllers, upon which the controller stops (rather than
+  /// shutting down ros, which would also stop any nodelets sharing the process).
+  inline void setFatalError(void) { fatal_error_ = true; };
+
   /// Modifier for the current pose of the robot model body.
   /// @param[in] pose The input pose to be set as the current robot model body pose
   inline void setCurrentPose(const Pose& pose)  { current_pose_ = pose; };
@@ -104,6 +113,10 @@ public:
   /// @param[in] model A pointer to a existing reference robot model object
   void generate(std::shared_ptr<Model> model = NULL);
 
+  /// Creates the worker pool used for parallel leg updates, if requested by parameters. Called from the control thread
+  /// once its scheduling and CPU affinity are configured, since workers adopt its priority and avoid its core.
+  void initWorkerPool(void);
+
   /// Iterate through legs in robot model and have them run their initialisation.
   /// @param[in] use_default_joint_positions Flag denoting if the leg should initialise using default joint position
   /// values for any joint with unknown current position values
@@ -161,6 +174,12 @@ public:
   /// Updates model configuration by applying inverse kinematics to solve desired tip poses generated from walk/pose
   /// controllers.
   void updateModel(void);
+
+  /// Applies an update function to each leg of the robot model. Legs are updated in parallel across the worker pool if
+  /// one exists, otherwise serially, returning once all legs are updated. The update of each leg must only modify
+  /// state of that leg (and its child objects).
+  /// @param[in] update The update function which takes a pointer to the leg to be updated
+  void updateLegs(const std::function<void(std::shared_ptr<Leg>)> &update);
   
   /// Estimates the acceleration vector due to gravity from pitch and roll orientations from IMU data
   /// @return The estimated acceleration vector due to gravity.
@@ -176,6 +195,9 @@ private:
   Pose current_pose_;            ///< Current pose of robot model body (i.e. walk_plane -> base_link)
   Pose default_pose_;            ///< Default pose of robot model body (i.e. only body clearance above walk plane)
   ImuData imu_data_;             ///< Imu data structure
+  bool fatal_error_ = false;     ///< Flag denoting if an unrecoverable error has occurred
+
+  std::shared_ptr<WorkerPool> worker_pool_; ///< Pointer to worker pool used for parallel leg updates (if requested)
   
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -215,6 +237,10 @@ public:
   /// @return The identification number of the leg object
   inline int getIDNumber(void) { return id_number_; };
 
+  /// Accessor for the parent robot model object of this leg.
+  /// @return Pointer to the parent robot model object
+  inline std::shared_ptr<Model> getModel(void) { return model_; };
+
   /// Accessor for the number of child joint objects for this leg.
   /// @return The number of child joint objects of the leg
   inline int getJointCount(void) { return joint_count_; };
@@ -251,6 +277,10 @@ public:
   /// @return The current estimated pose of the steppping surface plane
   inline Pose getStepPlanePose(void) { return step_plane_pose_; };
 
+  /// Accessor for the number of inverse kinematics deviations of this leg since creation.
+  /// @return The number of (non-simulated) applications of inverse kinematics which deviated from the desired tip pose
+  inline int getIKDeviationCount(void) { return ik_deviation_count_; };
+
   /// Accessor for the current admittance control position offset for this leg.
   /// @return The current admittance control position offset for the leg
   inline Eigen::Vector3d getAdmittanceDelta(void) { return admittance_delta_; };
@@ -379,9 +409,17 @@ public:
   /// @param[in] damping_ratio The new virtual damping ratio value
   inline void setVirtualDampingRatio(const double& damping_ratio) { virtual_damping_ratio_ = damping_ratio; };
 
-  /// Publishes the given message via the leg state pubisher object.
-  /// @param[in] msg The leg state message to be published
-  inline void publishState(const syropod_highlevel_controller::LegState& msg) { leg_state_publisher_.publish(msg); };
+  /// Publishes the given message via the leg state pubisher object. Being published by shared pointer, subscribers
+  /// within the same process (i.e. nodelets) receive the message without serialisation.
+  /// @param[in] msg Shared pointer to the leg state message to be published, which must not be modified thereafter
+  inline void publishState(const boost::shared_ptr<const syropod_highlevel_controller::LegState>& msg)
+  {
+    leg_state_publisher_.publish(msg);
+  };
+
+  /// Accessor for the number of subscribers to the leg state publisher object.
+  /// @return The number of subscribers to leg state messages of this leg
+  inline uint getStateSubscriberCount(void) { return leg_state_publisher_.getNumSubscribers(); };
 
   /// Publishes the given message via the ASC leg state pubisher object.
   /// @param[in] msg The ASC leg state message to be published
@@ -407,7 +445,9 @@ public:
   /// @return The interpolated workplane at input height
   Workplane getWorkplane(const double& height);
   
-  /// Generates a reachable tip position from an input test tip position within the workspace of this leg.
+  /// Generates a reachable tip position from an input test tip position within the workspace of this leg. Test tip
+  /// positions beyond the workplane limits (defined about the identity tip position) are moved back to the limit along
+  /// the same bearing from the identity tip position, with height limited to within the workspace.
   /// @param[in] reference_tip_position The tip position to use as reference to generate a reachable tip position
   /// @return A reachable tip position which lies within the leg workspace based on the input reference tip position
   Eigen::Vector3d makeReachable(const Eigen::Vector3d& reference_tip_position);
@@ -415,9 +455,16 @@ public:
   /// Updates joint default positions according to current joint positions.
   void updateDefaultConfiguration(void);
 
-  /// Generates a JointState message from the desired state of the joints of the leg object.
-  /// @param[out] joint_state_msg The output JointState mesage to fill with the state of joints within this leg object
-  void generateDesiredJointStateMsg(sensor_msgs::JointState* joint_state_msg);
+  /// Appends an entry for each joint of the leg object to a JointState message, sizing it for subsequent updates.
+  /// @param[out] joint_state_msg The JointState message to which the joint names and zeroed states are appended
+  void initDesiredJointStateMsg(sensor_msgs::JointState* joint_state_msg);
+
+  /// Writes the desired state of the joints of the leg object in place into a JointState message previously sized via
+  /// initDesiredJointStateMsg, without modifying the joint names or message size.
+  /// @param[out] joint_state_msg The JointState message to update with the desired state of joints within this leg
+  /// @param[in] index The index within the message of the first joint of this leg object
+  /// @return The index within the message following the last joint of this leg object
+  int updateDesiredJointStateMsg(sensor_msgs::JointState* joint_state_msg, const int &index);
 
   /// Returns pointer to joint requested via identification number input.
   /// @param[in] joint_id_number The identification name of the requested joint object pointer
@@ -491,6 +538,11 @@ public:
   /// @return Calculated new tip pose by applying forward kinematics
   Pose applyFK(const bool& set_current = true, const bool& use_actual = false);
 
+  /// Calculates the tip pose by forward kinematics from the actual (hardware) joint positions, without modifying joint
+  /// transforms or the current tip pose of the model.
+  /// @return Calculated tip pose by applying forward kinematics to actual joint positions
+  Pose calculateActualTipPose(void) const;
+
 private:
   std::shared_ptr<Model> model_;     ///< A pointer to the parent robot model object
   const Parameters& params_;         ///< Pointer to parameter data structure for storing parameter variables
@@ -530,6 +582,7 @@ private:
   Eigen::Vector3d tip_force_measured_;    ///< Measured force estimation on the tip
   Eigen::Vector3d tip_torque_measured_;   ///< Measured torque estimation on the tip
   Pose step_plane_pose_;                  ///< Estimation of the pose of the stepping surface plane
+  int ik_deviation_count_ = 0;            ///< Number of inverse kinematics deviations from desired tip pose
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
@@ -10,6 +10,7 @@
 #define SYROPOD_HIGHLEVEL_CONTROLLER_PARAMETERS_AND_STATES_H
 
 #include "standard_includes.h"
+#include "gait_tables.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// Designation for potential states of the entire top-level controller system.
@@ -46,6 +47,27 @@ enum GaitDesignation
   GAIT_DESIGNATION_COUNT, ///< Misc enum defining number of Gait Designations
   GAIT_UNDESIGNATED = -1, ///< Undesignated gait
 };
+static_assert(GAIT_DESIGNATION_COUNT == BUILTIN_GAIT_COUNT, "Each gait designation requires a built-in gait table");
+
+/// Returns the name of a designated gait, as defined in config/gait.yaml.
+/// @param[in] gait The gait designation
+/// @return The gait name, or an empty string if the gait is undesignated
+inline std::string getGaitType(const GaitDesignation &gait)
+{
+  switch (gait)
+  {
+    case (TRIPOD_GAIT):
+      return "tripod_gait";
+    case (RIPPLE_GAIT):
+      return "ripple_gait";
+    case (WAVE_GAIT):
+      return "wave_gait";
+    case (AMBLE_GAIT):
+      return "amble_gait";
+    default:
+      return "";
+  }
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// Designation for potential manual body posing input modes.
@@ -187,6 +209,163 @@ enum SequenceSelection
   SEQUENCE_SELECTION_COUNT, ///< Misc enum defining number of System States
 };
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Designation for the timed stages of each control loop cycle.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+enum UpdateStage
+{
+  WALK_STAGE,                ///< Walk controller tip trajectory generation for walking and manually controlled legs
+  POSE_STAGE,                ///< Pose controller application of body posing to tip poses
+  MODEL_STAGE,               ///< Model application of inverse/forward kinematics to desired tip poses
+  CURRENT_POSE_STAGE,        ///< Pose controller update of current body pose from all posing sources
+  ADMITTANCE_STAGE,          ///< Admittance controller update of tip position offsets
+  LEG_STATE_PUBLISH_STAGE,   ///< Publishing of leg states
+  VELOCITY_PUBLISH_STAGE,    ///< Publishing of body velocity
+  POSE_PUBLISH_STAGE,        ///< Publishing of body pose
+  WALKSPACE_PUBLISH_STAGE,   ///< Publishing of walkspace
+  GAIT_PUBLISH_STAGE,        ///< Publishing of gait selection
+  ODOMETRY_PUBLISH_STAGE,    ///< Publishing of odometry
+  POSE_ERROR_PUBLISH_STAGE,  ///< Publishing of rotation pose error
+  TRANSFORM_PUBLISH_STAGE,   ///< Broadcasting of frame transforms
+  JOINT_STATE_PUBLISH_STAGE, ///< Publishing of desired joint states
+  RVIZ_DEBUGGING_STAGE,      ///< Generation and publishing of RVIZ debugging markers
+  LOOP_STAGE,                ///< Entire control loop cycle, excluding sleep until the next cycle
+  UPDATE_STAGE_COUNT,        ///< Misc enum defining number of Update Stages
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Returns the local parameter store which is read in place of the ros parameter server if ros has not been initialised
+/// (i.e. when the controller is run without a ros master). Parameter values are keyed by full parameter name.
+/// @return Reference to the local parameter store
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline std::map<std::string, XmlRpc::XmlRpcValue>& getLocalParameters(void)
+{
+  static std::map<std::string, XmlRpc::XmlRpcValue> local_parameters;
+  return local_parameters;
+}
+
+/// Converts a parameter value from the local parameter store to boolean data.
+/// @param[in] value The parameter value
+/// @param[out] data The converted parameter data
+/// @return Bool denoting if the parameter value is of a compatible type
+inline bool convertParameter(XmlRpc::XmlRpcValue value, bool &data)
+{
+  bool valid = (value.getType() == XmlRpc::XmlRpcValue::TypeBoolean);
+  data = valid ? static_cast<bool&>(value) : data;
+  return valid;
+}
+
+/// Converts a parameter value from the local parameter store to integer data.
+/// @param[in] value The parameter value
+/// @param[out] data The converted parameter data
+/// @return Bool denoting if the parameter value is of a compatible type
+inline bool convertParameter(XmlRpc::XmlRpcValue value, int &data)
+{
+  bool valid = (value.getType() == XmlRpc::XmlRpcValue::TypeInt);
+  data = valid ? static_cast<int&>(value) : data;
+  return valid;
+}
+
+/// Converts a parameter value from the local parameter store to double data. Integer values are also accepted, as per
+/// the ros parameter server.
+/// @param[in] value The parameter value
+/// @param[out] data The converted parameter data
+/// @return Bool denoting if the parameter value is of a compatible type
+inline bool convertParameter(XmlRpc::XmlRpcValue value, double &data)
+{
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+  {
+    data = static_cast<int&>(value);
+    return true;
+  }
+  bool valid = (value.getType() == XmlRpc::XmlRpcValue::TypeDouble);
+  data = valid ? static_cast<double&>(value) : data;
+  return valid;
+}
+
+/// Converts a parameter value from the local parameter store to string data.
+/// @param[in] value The parameter value
+/// @param[out] data The converted parameter data
+/// @return Bool denoting if the parameter value is of a compatible type
+inline bool convertParameter(XmlRpc::XmlRpcValue value, std::string &data)
+{
+  bool valid = (value.getType() == XmlRpc::XmlRpcValue::TypeString);
+  data = valid ? static_cast<std::string&>(value) : data;
+  return valid;
+}
+
+/// Copies a parameter value from the local parameter store, such as a struct of parameters to be enumerated.
+/// @param[in] value The parameter value
+/// @param[out] data The copied parameter data
+/// @return Bool denoting if the parameter value is of a compatible type (always true)
+inline bool convertParameter(XmlRpc::XmlRpcValue value, XmlRpc::XmlRpcValue &data)
+{
+  data = value;
+  return true;
+}
+
+/// Converts a parameter value from the local parameter store to vector data.
+/// @param[in] value The parameter value
+/// @param[out] data The converted parameter data
+/// @return Bool denoting if the parameter value and all elements are of a compatible type
+template <typename T>
+inline bool convertParameter(XmlRpc::XmlRpcValue value, std::vector<T> &data)
+{
+  if (value.getType() != XmlRpc::XmlRpcValue::TypeArray)
+  {
+    return false;
+  }
+  std::vector<T> converted(value.size());
+  for (int i = 0; i < value.size(); ++i)
+  {
+    if (!convertParameter(value[i], converted[i]))
+    {
+      return false;
+    }
+  }
+  data = converted;
+  return true;
+}
+
+/// Converts a parameter value from the local parameter store to map data.
+/// @param[in] value The parameter value
+/// @param[out] data The converted parameter data
+/// @return Bool denoting if the parameter value and all members are of a compatible type
+template <typename T>
+inline bool convertParameter(XmlRpc::XmlRpcValue value, std::map<std::string, T> &data)
+{
+  if (value.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+  {
+    return false;
+  }
+  std::map<std::string, T> converted;
+  for (XmlRpc::XmlRpcValue::iterator it = value.begin(); it != value.end(); ++it)
+  {
+    if (!convertParameter(it->second, converted[it->first]))
+    {
+      return false;
+    }
+  }
+  data = converted;
+  return true;
+}
+
+/// Gets parameter data from the ros parameter server or, if ros has not been initialised, the local parameter store.
+/// @param[in] name The full name of the parameter
+/// @param[out] data The parameter data
+/// @return Bool denoting if the parameter was found and is of a compatible type
+template <typename T>
+inline bool getParameter(const std::string &name, T &data)
+{
+  if (ros::isInitialized())
+  {
+    ros::NodeHandle n;
+    return n.getParam(name, data);
+  }
+  std::map<std::string, XmlRpc::XmlRpcValue>::iterator it = getLocalParameters().find(name);
+  return it != getLocalParameters().end() && convertParameter(it->second, data);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// This structure contains the data associated with a parameter acquired from the ros parameter server via a self
 /// initialisation function.
@@ -203,14 +382,29 @@ public:
                    const std::string &base_parameter_name = "/syropod/parameters/",
                    const bool &required_input = true)
   {
-    ros::NodeHandle n;
     name = name_input;
     required = required_input;
-    initialised = n.getParam(base_parameter_name + name_input, data);
+    initialised = getParameter(base_parameter_name + name_input, data);
     ROS_ERROR_COND(!initialised && required_input, "Error reading parameter/s %s from rosparam."
                    " Check config file is loaded and type is correct\n", name.c_str());
   }
 
+  /// Initialisation function for optional parameters, which self populates parameter data from ros parameter server
+  /// or otherwise assigns the input default data (e.g. for parameters missing from older config files).
+  /// @param[in] name_input The unique name of the parameter to look for on ros parameter server
+  /// @param[in] default_data The data assigned if the parameter is not found on ros parameter server
+  /// @param[in] base_parameter_name The base parameter name prepended to 'name_input' common to all parameters
+  inline void initOptional(const std::string &name_input,
+                           const T &default_data,
+                           const std::string &base_parameter_name = "/syropod/parameters/")
+  {
+    init(name_input, base_parameter_name, false);
+    if (!initialised)
+    {
+      data = default_data;
+    }
+  }
+
   std::string name;         ///< Name of the parameter
   T data;                   ///< Data which defines parameter
   bool required = true;     ///< Denotes if this parameter is required to be initialised
@@ -235,10 +429,9 @@ public:
                    const std::string& base_parameter_name = "/syropod/parameters/",
                    const bool& required_input = true)
   {
-    ros::NodeHandle n;
     name = name_input;
     required = required_input;
-    initialised = n.getParam(base_parameter_name + name_input, data);
+    initialised = getParameter(base_parameter_name + name_input, data);
     ROS_ERROR_COND(!initialised && required_input, "Error reading parameter/s %s from rosparam."
                    " Check config file is loaded and type is correct\n", name.c_str());
 
@@ -273,17 +466,22 @@ struct Parameters
   AdjustableMapType adjustable_map;  ///< Map between adjustable parameter designations and associated Parameter object
 
   // Control parameters
-  Parameter<double> time_delta;        ///< The period of time between successive ros cycles
-  Parameter<bool> imu_posing;          ///< Flag denoting if the imu posing feature is on/off
-  Parameter<bool> auto_posing;         ///< Flag denoting if the auto posing feature is on/off
-  Parameter<bool> manual_posing;       ///< Flag denoting if the manual posing feature is on/off
-  Parameter<bool> inclination_posing;  ///< Flag denoting if the inclination posing feature is on/off
-  Parameter<bool> rough_terrain_mode;  ///< Flag denoting if rough terrain mode is on/off (affects various systems)
-  Parameter<bool> admittance_control;  ///< Flag denoting if the admittance control feature is on/off
+  Parameter<double> time_delta;           ///< The period of time between successive ros cycles
+  Parameter<bool> imu_posing;             ///< Flag denoting if the imu posing feature is on/off
+  Parameter<bool> auto_posing;            ///< Flag denoting if the auto posing feature is on/off
+  Parameter<bool> manual_posing;          ///< Flag denoting if the manual posing feature is on/off
+  Parameter<bool> inclination_posing;     ///< Flag denoting if the inclination posing feature is on/off
+  Parameter<bool> rough_terrain_mode;     ///< Flag denoting if rough terrain mode is on/off (affects various systems)
+  Parameter<bool> admittance_control;     ///< Flag denoting if the admittance control feature is on/off
+  Parameter<int> leg_update_threads;      ///< Number of worker threads used to update legs in parallel (0 = serial)
+  Parameter<int> control_thread_priority; ///< Real-time (SCHED_FIFO) priority of the control thread (0 = normal)
+  Parameter<int> control_thread_core;     ///< CPU core to which the control thread is pinned (-1 = unpinned)
 
   // Motor Interface parameters
-  Parameter<bool> individual_control_interface;   ///< Flag requesting the individual desired joint position format
-  Parameter<bool> combined_control_interface;     ///< Flag requesting the combined desired joint position format
+  Parameter<bool> individual_control_interface;    ///< Flag requesting the individual desired joint position format
+  Parameter<bool> combined_control_interface;      ///< Flag requesting the combined desired joint position format
+  Parameter<bool> intra_process_control_interface; ///< Flag requesting combined format be published by shared pointer
+  Parameter<bool> shared_memory_control_interface; ///< Flag requesting joint states be exchanged via shared memory
 
   // Model parameters
   Parameter<std::string> syropod_type;             ///< The type of the robot described by these parameters
@@ -308,12 +506,21 @@ struct Parameters
   AdjustableParameter step_depth;                   ///< The stepping depth used to find ground contact
   AdjustableParameter stance_span_modifier;         ///< The modifier for stance width (-1.0=min, 1.0=max)
   Parameter<std::string> velocity_input_mode;       ///< Determines velocity input as 'real' or 'throttle' based
+  Parameter<std::string> step_frequency_mode;       ///< Determines step frequency as 'fixed', 'continuous' or 'cadence'
+  Parameter<bool> auto_gait_selection;              ///< Flag denoting if gait/step frequency is selected automatically
+  Parameter<bool> footstep_planning;                ///< Flag denoting if footsteps are planned in-process when walking
+  Parameter<int> footstep_planning_horizon;         ///< Number of future footsteps planned for each leg
+  Parameter<double> footstep_planning_resolution;   ///< Resolution of footstep search grid (m)
+  Parameter<double> terrain_map_resolution;         ///< Resolution of terrain height map cells (m)
+  Parameter<bool> odometry_fusion;                  ///< Flag denoting if ideal odometry is fused with leg kinematics
   Parameter<double> body_velocity_scaler;           ///< Scales all body velocity inputs
   Parameter<bool> force_cruise_velocity;            ///< Flag denoting if cruise control mode uses set values
   Parameter<double> angular_cruise_velocity;        ///< Set values used in cruise control mode if requested
   Parameter<double> cruise_control_time_limit;      ///< Time limit after which cruise control input will zero
   Parameter<bool> overlapping_walkspaces;           ///< Flag denoting if walkspaces are allowed to overlap
   Parameter<bool> force_normal_touchdown;           ///< Flag denoting if tip touches down normal to walk plane
+  Parameter<bool> swing_optimisation;               ///< Flag denoting if swing trajectory apex is optimised
+  Parameter<bool> adaptive_swing_timing;            ///< Flag denoting if swing period ends early upon touchdown
   Parameter<bool> gravity_aligned_tips;             ///< Flag denoting if tip should align with gravity direction
   Parameter<double> touchdown_threshold;            ///< Threshold of tip force before touchdown is recognized
   Parameter<double> liftoff_threshold;              ///< Threshold of tip force before liftoff is recognized
@@ -348,6 +555,7 @@ struct Parameters
   Parameter<int> swing_phase;                              ///< The ratio of the entire step cycle which is in 'swing'
   Parameter<int> phase_offset;                             ///< The phase offset between step cycles of successive legs
   Parameter<std::map<std::string, int>> offset_multiplier; ///< The leg dependent multiplier for the step cycle offset
+  GaitTable gait_table;                                    ///< Step cycle timing resolved from above gait parameters
 
   //Auto pose parameters
   Parameter<double> pose_frequency;                                   ///< Frequency at which all auto posing cycles run
@@ -375,6 +583,8 @@ struct Parameters
   Parameter<bool> debug_workspace_calc;      ///< Flag determining if workspace calculations output debug info
   Parameter<bool> debug_IK;                  ///< Flag determining if inverse kinematics engine outputs debug info
   Parameter<bool> debug_rviz;                ///< Flag determining if visualisation markers are output for debugging
+  Parameter<bool> debug_loop_timing;         ///< Flag determining if control loop stage timing is recorded/published
+  Parameter<std::map<std::string, double>> telemetry_rates; ///< Maximum publishing rate of each telemetry topic (Hz)
 
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_SHARED_MEMORY_INTERFACE_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_SHARED_MEMORY_INTERFACE_H
+
+#include "standard_includes.h"
+#include "parameters_and_states.h"
+#include "shared_memory_layout.h"
+
+#include "model.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// This class provides a hardware interface via a POSIX shared memory segment, as an alternative to exchanging joint
+/// commands and feedback over ros topics with a co-located hardware driver. The segment is created on construction and
+/// holds the joint names of the model, a desired joint state command block written each control cycle and a current
+/// joint state block written by the driver. Both blocks are seqlock protected, and the driver may sleep on the command
+/// block sequence (futex) to be woken as soon as each command is written.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class SharedMemoryInterface
+{
+public:
+  /// Constructor for the shared memory interface. Creates (or reinitialises) and maps the shared memory segment.
+  /// @param[in] model Pointer to the robot model object whose joints are commanded and updated via the segment
+  /// @param[in] name The name of the POSIX shared memory segment
+  SharedMemoryInterface(std::shared_ptr<Model> model, const std::string &name = SHARED_MEMORY_NAME);
+
+  /// Destructor for the shared memory interface. Marks the segment as closed, then unmaps and unlinks it.
+  ~SharedMemoryInterface(void);
+
+  /// Accessor for whether the shared memory segment was successfully created and mapped.
+  /// @return Flag denoting if the shared memory segment is open
+  inline bool isOpen(void) { return layout_ != NULL; };
+
+  /// Writes the desired state of each joint of the model to the command block and wakes the hardware driver.
+  void writeCommand(void);
+
+  /// Reads the current joint state block and, if written by the hardware driver since the previous read, assigns the
+  /// current state of each joint of the model.
+  /// @return Flag denoting if new joint state was assigned
+  bool readState(void);
+
+private:
+  std::string name_;                           ///< The name of the POSIX shared memory segment
+  int file_descriptor_ = -1;                   ///< File descriptor of the shared memory segment
+  SharedMemoryLayout* layout_ = NULL;          ///< Pointer to the mapped shared memory segment, null if not open
+  std::vector<std::shared_ptr<Joint>> joints_; ///< Joints of the model, in order of the segment joint data
+  JointStateData state_data_;                  ///< Copy of joint state data from the most recent read
+  uint32_t state_sequence_ = 0;                ///< Sequence of the joint state block at the most recent read
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_SHARED_MEMORY_INTERFACE_H
@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_SHARED_MEMORY_LAYOUT_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_SHARED_MEMORY_LAYOUT_H
+
+// Deliberately free of ros and controller dependencies, such that hardware drivers may map the segment directly.
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define SHARED_MEMORY_NAME "/syropod_hardware_interface" ///< Name of the POSIX shared memory segment
+#define SHARED_MEMORY_VERSION 1                          ///< Layout version, zero whilst segment is not initialised
+#define SHARED_MEMORY_MAX_JOINTS 64                      ///< Max number of joints held in the segment
+#define SHARED_MEMORY_NAME_LENGTH 32                     ///< Max length of joint names (including null terminator)
+#define SEQLOCK_MAX_RETRIES 100                          ///< Max attempts at a consistent read before giving up
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared memory sequence counters must be lock free");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Sequence counters are also used as futex words");
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Joint state data exchanged through the shared memory segment, ordered as per the joint names of the segment.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct JointStateData
+{
+  int64_t stamp_;                             ///< Time of writing (CLOCK_MONOTONIC nanoseconds)
+  uint32_t velocity_valid_;                   ///< Flag denoting if velocity values are populated
+  uint32_t effort_valid_;                     ///< Flag denoting if effort values are populated
+  double position_[SHARED_MEMORY_MAX_JOINTS]; ///< Joint positions (radians)
+  double velocity_[SHARED_MEMORY_MAX_JOINTS]; ///< Joint velocities (radians per second)
+  double effort_[SHARED_MEMORY_MAX_JOINTS];   ///< Joint efforts
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Joint state data protected by a seqlock. The single writer increments the sequence to an odd value before writing
+/// and to the next even value after, whilst readers copy the data and retry if the sequence was odd or changed. The
+/// sequence doubles as a futex word, such that readers may sleep until the next write.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct JointStateBlock
+{
+  std::atomic<uint32_t> sequence_; ///< Seqlock sequence, odd whilst data is being written
+  JointStateData data_;            ///< The protected joint state data
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Layout of the shared memory segment. Created and initialised by the controller, which is the single writer of the
+/// command block, whilst a co-located hardware driver is the single writer of the state block.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct SharedMemoryLayout
+{
+  std::atomic<uint32_t> version_;                                        ///< Layout version, zero whilst closed
+  uint32_t joint_count_;                                                 ///< Number of joints held in the segment
+  char joint_names_[SHARED_MEMORY_MAX_JOINTS][SHARED_MEMORY_NAME_LENGTH]; ///< Joint names, in order of joint data
+  JointStateBlock command_;                                              ///< Desired joint state written by controller
+  JointStateBlock state_;                                                ///< Current joint state written by driver
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Returns the current time of the monotonic clock, as used to stamp joint state data.
+/// @return The current time (CLOCK_MONOTONIC nanoseconds)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline int64_t getMonotonicTime(void)
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Marks the start of writing data of a joint state block. Must only be called by the single writer of the block.
+/// @param[in,out] block The joint state block
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline void beginBlockWrite(JointStateBlock *block)
+{
+  block->sequence_.store(block->sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Marks the end of writing data of a joint state block and wakes any readers waiting on the block.
+/// @param[in,out] block The joint state block
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline void endBlockWrite(JointStateBlock *block)
+{
+  block->sequence_.store(block->sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&block->sequence_), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Copies a consistent snapshot of the data of a joint state block, retrying whilst the writer is mid write.
+/// @param[in] block The joint state block
+/// @param[out] data The copied joint state data
+/// @param[out] sequence The (even) sequence of the block at time of copy
+/// @return Flag denoting if a consistent copy was made within the max number of attempts
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline bool readBlock(const JointStateBlock *block, JointStateData *data, uint32_t *sequence)
+{
+  for (int attempt = 0; attempt < SEQLOCK_MAX_RETRIES; ++attempt)
+  {
+    uint32_t start_sequence = block->sequence_.load(std::memory_order_acquire);
+    if (start_sequence % 2 != 0)
+    {
+      continue;
+    }
+    std::memcpy(data, &block->data_, sizeof(JointStateData));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (block->sequence_.load(std::memory_order_relaxed) == start_sequence)
+    {
+      *sequence = start_sequence;
+      return true;
+    }
+  }
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Sleeps until the sequence of a joint state block differs from the given sequence, or until timeout.
+/// @param[in] block The joint state block
+/// @param[in] sequence The sequence of the block at time of previous read
+/// @param[in] timeout The max relative time to wait, or NULL to wait indefinitely
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline void waitForBlockWrite(JointStateBlock *block, const uint32_t &sequence, const timespec *timeout)
+{
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&block->sequence_), FUTEX_WAIT, sequence, timeout, NULL, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_SHARED_MEMORY_LAYOUT_H
@@ -13,6 +13,7 @@
 #include <ros/console.h>
 #include <ros/assert.h>
 #include <ros/exceptions.h>
+#include <ros/callback_queue.h>
 
 #include <dynamic_reconfigure/server.h>
 
@@ -32,6 +33,10 @@
 #include <geometry_msgs/Transform.h>
 #include <geometry_msgs/TransformStamped.h>
 
+#include <nav_msgs/Odometry.h>
+
+#include <diagnostic_msgs/DiagnosticArray.h>
+
 #include <visualization_msgs/Marker.h>
 #include <visualization_msgs/MarkerArray.h>
 
@@ -45,9 +50,12 @@
 #include <sstream>
 #include <string.h>
 #include <vector>
+#include <deque>
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory>
+#include <array>
+#include <chrono>
 
 #define UNASSIGNED_VALUE double(INT_MAX) ///< Value used to determine if variable has been assigned
 #define PROGRESS_COMPLETE 100            ///< Value denoting 100% and a completion of progress of various functions
@@ -22,9 +22,42 @@
 
 #include "debug_visualiser.h"
 #include "admittance_controller.h"
+#include "input_buffer.h"
+#include "loop_profiler.h"
+#include "telemetry_publisher.h"
+#include "shared_memory_interface.h"
 
 #define MAX_MANUAL_LEGS 2 ///< Maximum number of legs able to be manually manipulated simultaneously
 #define PACK_TIME 2.0     ///< Joint transition time during pack/unpack sequences (seconds @ step frequency == 1.0)
+#define AUTO_GAIT_SPEED_RATIO 0.8     ///< Max proportion of speed limits used by an automatically selected gait
+#define AUTO_GAIT_SELECTION_DELAY 1.0 ///< Time a new automatic gait selection must persist before applied (seconds)
+#define JOINT_STATE_MSG_POOL_SIZE 3   ///< Number of desired joint state messages cycled when publishing intra-process
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Object containing the step cycle timing parameters of a gait defined in config/gait.yaml, loaded once at
+/// initialisation such that gait speed limits may be generated without access to the parameter server.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct GaitDefinition
+{
+  std::string gait_type_;       ///< The gait name as defined in config/gait.yaml
+  GaitDesignation gait_;        ///< The gait designation, undesignated for custom gaits
+  int stance_phase_;            ///< The ratio of the entire step cycle which is in 'stance'
+  int swing_phase_;             ///< The ratio of the entire step cycle which is in 'swing'
+  GaitTable gait_table_;        ///< Step cycle timing resolved from gait parameters
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Object containing the speed limits of a gait at a given step frequency, used for automatic gait selection.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct GaitLimits
+{
+  std::string gait_type_;       ///< The gait name as defined in config/gait.yaml
+  GaitDesignation gait_;        ///< The gait designation, undesignated for custom gaits
+  double step_frequency_;       ///< The step frequency parameter value at which limits were generated
+  double stance_ratio_;         ///< The proportion of the step cycle each leg spends in stance
+  LimitMap max_linear_speed_;   ///< A map of max allowable linear body speeds for potential bearings
+  LimitMap max_angular_speed_;  ///< A map of max allowable angular speeds for potential bearings
+};
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// This class creates and initialises all ros publishers/subscriptions; sub-controllers: Walk Controller,
@@ -41,9 +74,16 @@ class StateController
 {
 public:
   /// StateController class constructor. Initialises parameters, creates robot model object, sets up ros topic
-  /// subscriptions and advertisments.
+  /// subscriptions and advertisments using the global and private ("~") namespaces of the process. Used by the
+  /// standalone node, or when running headless (without a ros master) in which case no ros communication is set up.
   StateController(void);
 
+  /// StateController class constructor using the given node handles for ros communication. Used by the nodelet, whose
+  /// namespaces differ from those of the process (i.e. the nodelet manager).
+  /// @param[in] node_handle Node handle used for topic subscriptions and advertisements
+  /// @param[in] private_node_handle Node handle of the private namespace, used by the dynamic reconfigure server
+  StateController(const ros::NodeHandle &node_handle, const ros::NodeHandle &private_node_handle);
+
   /// StateController object destructor.
   ~StateController(void);
 
@@ -55,10 +95,38 @@ public:
   /// @return Current state of the system
   inline SystemState getSystemState(void) { return system_state_; };
 
+  /// Accessor for robot state member.
+  /// @return Current state of the robot
+  inline RobotState getRobotState(void) { return robot_state_; };
+
   /// Returns true if all joint objects in model have been initialised with a current position.
   /// @return Flag denoting whether all joint objects in model have been initialised with a current position
   inline bool jointPositionsInitialised(void) { return joint_positions_initialised_; };
 
+  /// Returns true if an unrecoverable error has occurred in the state controller, model or its controllers, upon which
+  /// the controller must stop running.
+  /// @return Flag denoting whether an unrecoverable error has occurred
+  inline bool hasFatalError(void) { return fatal_error_ || (model_ && model_->hasFatalError()); };
+
+  /// Accessor for the robot model object.
+  /// @return Pointer to the robot model object
+  inline std::shared_ptr<Model> getModel(void) { return model_; };
+
+  /// Accessor for the walk controller object.
+  /// @return Pointer to the walk controller object
+  inline std::shared_ptr<WalkController> getWalker(void) { return walker_; };
+
+  /// Accessor for the durations of each stage of the most recent state controller loop (requires loop timing enabled).
+  /// @return Array of stage durations (seconds) indexed by UpdateStage, zero for stages not executed in the loop
+  inline std::array<double, UPDATE_STAGE_COUNT> getStageDurations(void)
+  {
+    return loop_profiler_->getLatestDurations();
+  };
+
+  /// Accessor for the loop profiler which records timing of each stage of the control loop.
+  /// @return Pointer to the loop profiler
+  inline std::shared_ptr<LoopProfiler> getLoopProfiler(void) { return loop_profiler_; };
+
   /// Initialises the model by calling the model object function initLegs().
   /// @param[in] use_default_joint_positions Flag indicating whether to use default joint positions or not
   inline void initModel(const bool &use_default_joint_positions = false)
@@ -76,11 +144,28 @@ public:
 
   /// Acquires gait selection defined parameter values from the ros param server and initialises parameter objects.
   /// @param[in] gait_selection The desired gait used to acquire associated parameters off the parameter server
-  void initGaitParameters(const GaitDesignation &gait_selection);
+  /// @return Flag denoting if step cycle timing could be generated from the gait parameters
+  bool initGaitParameters(const GaitDesignation &gait_selection);
+
+  /// Acquires parameter values of a gait from the ros param server and initialises parameter objects.
+  /// @param[in] gait_type The name of the gait (as defined in config/gait.yaml) whose parameters are acquired
+  /// @return Flag denoting if step cycle timing could be generated from the gait parameters (i.e. the robot has no more
+  /// legs than supported by gait definitions and an offset multiplier is defined for each leg)
+  bool initGaitParameters(const std::string &gait_type);
+
+  /// Acquires the step cycle timing parameters of every gait defined under the gait parameters namespace, from which
+  /// speed limit tables are generated for automatic gait selection. Parameters of the current gait are restored.
+  void initGaitDefinitions(void);
 
   /// Acquires auto pose parameter values from the ros param server and initialises parameter objects.
   void initAutoPoseParameters(void);
 
+  /// Passes all messages received since the previous call to their associated callbacks and services any dynamic
+  /// reconfigure requests. Subscribed messages are buffered by the ros spinner thread so that all callbacks are
+  /// executed by the thread calling this function (i.e. the control thread) between iterations of the main loop.
+  /// Also reads the latest joint state from the shared memory hardware interface, if in use.
+  void processInputs(void);
+
   /// The main loop of the state controller (called from the main ros loop).
   /// Coordinates with other controllers to update based on current robot state, also calls for state transitions.
   void loop(void);
@@ -94,13 +179,31 @@ public:
   /// Updates the walk/pose controllers tip positions and applies inverse kinematics to the leg objects.
   void runningState(void);
 
-  /// Updates adjustment of parameters.
-  /// @todo Implement smooth "whilst walking" adjustment of step_frequency and body_clearance
+  /// Updates adjustment of parameters. Unless step_frequency_mode is 'fixed', new step_frequency values are applied
+  /// immediately and adapted into the walk cycle by the walk controller.
+  /// @todo Implement smooth "whilst walking" adjustment of body_clearance
   void adjustParameter(void);
 
-  /// Handles a gait change event. Forces robot velocity input to zero until it is in a STOPPED walk state and then
-  /// updates gait parameters based on the new gait selection and reinitialises the walk controller with the new
-  /// parameters. If required the pose controller is reinitialised with new 'auto posing' parameters.
+  /// Updates the dynamic reconfigure server with the current value of each dynamically adjustable parameter, such that
+  /// adjustments made other than via dynamic reconfigure (e.g. joystick or automatic selection) are reflected.
+  void updateDynamicConfig(void);
+
+  /// Generates speed limit tables for each gait definition over a grid of step frequencies, spanning the
+  /// step_frequency default to max values in adjustment steps (or only the current value in 'fixed' step frequency
+  /// mode). Step cycles and limits are generated from the timing of each gait definition, leaving parameters untouched.
+  void generateGaitLimits(void);
+
+  /// Selects the gait and step frequency able to achieve the commanded velocity with the greatest stability margin.
+  /// Gaits with a larger proportion of the step cycle in stance are preferred, provided the commanded velocity is
+  /// within AUTO_GAIT_SPEED_RATIO of the gait's speed limits, at the lowest such step frequency. A new selection is
+  /// applied via the gait change/parameter adjustment mechanisms once it has persisted for AUTO_GAIT_SELECTION_DELAY
+  /// seconds, or immediately if the current selection is unable to achieve the commanded velocity.
+  void selectGait(void);
+
+  /// Handles a gait change event. Waits until the robot is in either a STOPPED or MOVING walk state and then updates
+  /// gait parameters based on the new gait selection. If STOPPED the walk controller is reinitialised with the new
+  /// parameters, otherwise the walk controller blends the walk cycle into the new gait whilst walking. If required the
+  /// pose controller is reinitialised with new 'auto posing' parameters.
   void changeGait(void);
 
   /// Handles a leg toggle event. Forces robot velocity input to zero until it is in a STOPPED walk state and then
@@ -116,30 +219,37 @@ public:
   /// the desired joint position on the leg member publisher object.
   void publishDesiredJointState(void);
 
-  /// Debugging functions
-
-  /// Iterates through leg objects and collates state information for publishing on custom leg state message topic.
-  /// @todo Remove ASC state messages in line with requested hardware changes to use legState message variable/s
-  void publishLegState(void);
-
-  /// Publishes current desired linear and angular body velocity for debugging.
-  void publishVelocity(void);
+  /// Acquires a preallocated combined desired joint state message which is not retained by any subscriber, such that it
+  /// may be updated in place. Only allocates a replacement message if every pooled message is still retained.
+  /// @return Shared pointer to the acquired desired joint state message
+  boost::shared_ptr<sensor_msgs::JointState> acquireDesiredJointStateMsg(void);
 
-  /// Publishes current pose (roll, pitch, yaw, x, y, z) for debugging.
-  void publishPose(void);
-
-  /// Publishes details about current workspace (average/min/max radius) for debugging.
-  void publishWalkspace(void);
+  /// Debugging functions
 
-  /// Publishes imu pose rotation absement, position and velocity errors used in the PID controller, for debugging.
-  void publishRotationPoseError(void);
+  /// Captures a telemetry snapshot of the robot state (leg states, body velocity/pose, walkspace, gait selection,
+  /// odometry, posing errors and joint frames) for publishing by the telemetry publisher thread. Also updates the fixed
+  /// frame used for external targets from odom availability reported by the telemetry publisher.
+  void publishTelemetry(void);
 
-  /// Publishes transforms linking world, base_link and walk_plane frames.
-  void publishFrameTransforms(void);
+  /// Collects external targets and defaults posted by the target tip pose callback (serviced earlier in the control
+  /// cycle) and sends them to the walk/pose controller depending on walk state. Targets posted whilst not running are
+  /// dropped.
+  void collectExternalTargets(void);
 
   /// Generates transforms for external leg stepper targets based on frame id and time.
   void generateExternalTargetTransforms(void);
 
+  /// Generates the transform of an external target between its reference frame at time of request and either the
+  /// current walk plane frame (pose of walk plane in reference frame) or current base link frame (pose of reference
+  /// frame in base link). Whilst using ideal odometry, the transform is composed from the current ideal odometry and
+  /// the transform at time of request, which is looked up from tf once and cached within the target (unless requested
+  /// at zero time, denoting the latest transform, which is looked up every call). Otherwise the transform is looked up
+  /// from tf via the external odom frame.
+  /// @param[in,out] external_target Pointer to the external target
+  /// @param[in] to_base_link Flag denoting if the transform is to the base link frame rather than walk plane frame
+  /// @return Flag denoting if the transform was generated
+  bool generateExternalTargetTransform(ExternalTarget *external_target, const bool &to_base_link);
+
   /// Sets up velocities for and calls debug output object to publish various debugging visualations via rviz.
   void RVIZDebugging(void);
 
@@ -254,6 +364,10 @@ public:
   /// @param[in] joint_states The JointState sensor message provided by the subscribed ros topic "/joint_states"
   void jointStatesCallback(const sensor_msgs::JointState &joint_states);
 
+  /// Flags if all joint objects have received an initial current position, from either the joint state topic or the
+  /// shared memory hardware interface.
+  void checkJointPositionsInitialised(void);
+
   /// Callback which handles acquisition of tip states from external sensors. Attempts to populate leg objects with
   /// available current tip force/torque values and range to walk surface.
   /// @param[in] tip_states The TipState sensor message provided by the subscribed ros topic "/tip_states"
@@ -272,6 +386,37 @@ public:
   void targetTipPoseCallback(const syropod_highlevel_controller::TargetTipPose &msg);
 
 private:
+  /// StateController class constructor to which the public constructors delegate.
+  /// @param[in] node_handle Node handle used for topic subscriptions and advertisements, null if running headless
+  /// @param[in] private_node_handle Node handle of the private namespace, null if running headless
+  StateController(std::shared_ptr<ros::NodeHandle> node_handle, std::shared_ptr<ros::NodeHandle> private_node_handle);
+
+  /// Subscribes to a topic, buffering received messages for execution of the callback by the control thread. Topics
+  /// with a queue size of one only buffer the latest message whilst others buffer up to the queue size of messages.
+  /// @param[in] n The ros node handle
+  /// @param[in] topic The name of the subscribed topic
+  /// @param[in] queue_size The size of the subscriber queue
+  /// @param[in] callback The callback handling each message
+  /// @return The subscriber of the topic
+  template <typename M>
+  ros::Subscriber subscribeBuffered(ros::NodeHandle &n, const std::string &topic, const int &queue_size,
+                                    void (StateController::*callback)(const M&))
+  {
+    std::function<void(const M&)> handler = std::bind(callback, this, std::placeholders::_1);
+    if (queue_size == 1)
+    {
+      std::shared_ptr<LatestInputBuffer<M>> buffer = std::make_shared<LatestInputBuffer<M>>(handler);
+      input_buffers_.push_back(buffer);
+      return n.subscribe(topic, queue_size, &LatestInputBuffer<M>::post, buffer.get());
+    }
+    else
+    {
+      std::shared_ptr<QueuedInputBuffer<M>> buffer = std::make_shared<QueuedInputBuffer<M>>(queue_size, handler);
+      input_buffers_.push_back(buffer);
+      return n.subscribe(topic, queue_size, &QueuedInputBuffer<M>::post, buffer.get());
+    }
+  };
+
   ros::Subscriber system_state_subscriber_;            ///< Subscriber for topic /syropod_remote/system_state
   ros::Subscriber robot_state_subscriber_;             ///< Subscriber for topic /syropod_remote/robot_state
   ros::Subscriber desired_velocity_subscriber_;        ///< Subscriber for topic /syropod_remote/desired_velocity
@@ -303,25 +448,36 @@ private:
   ros::Subscriber tip_state_subscriber_;   ///< Subscriber for topic /tip_states
 
   ros::Publisher desired_joint_state_publisher_; ///< Publisher for topic /desired_joint_state
-  ros::Publisher velocity_publisher_;            ///< Publisher for topic /shc/velocity
-  ros::Publisher pose_publisher_;                ///< Publisher for topic /shc/pose
-  ros::Publisher walkspace_publisher_;           ///< Publisher for topic /shc/walkspace
-  ros::Publisher rotation_pose_error_publisher_; ///< Publisher for topic /shc/rotation_pose_error
   ros::Publisher plan_step_request_publisher_;   ///< Publisher for topic /shc/plan_step_request
 
+  /// Pool of preallocated combined desired joint state messages, sized with joint names at initialisation
+  std::vector<boost::shared_ptr<sensor_msgs::JointState>> desired_joint_state_msgs_;
+
+  /// Hardware interface exchanging desired and current joint states with a co-located driver via shared memory
+  std::shared_ptr<SharedMemoryInterface> shared_memory_interface_;
+
   tf2_ros::Buffer transform_buffer_;
   std::shared_ptr<tf2_ros::TransformListener> transform_listener_;
-  tf2_ros::TransformBroadcaster transform_broadcaster_;
+  std::shared_ptr<TelemetryPublisher> telemetry_; ///< Publisher of telemetry on a low priority thread
+
+  std::vector<std::shared_ptr<InputBuffer>> input_buffers_; ///< Buffers of messages received from subscribed topics
+  ros::CallbackQueue control_callback_queue_;                ///< Callback queue serviced by the control thread
+
+  std::shared_ptr<ros::NodeHandle> node_handle_;         ///< Node handle for topics, null if running headless
+  std::shared_ptr<ros::NodeHandle> private_node_handle_; ///< Node handle of private namespace, null if running headless
 
   boost::recursive_mutex mutex_; ///< Mutex used in setup of dynamic reconfigure server
   dynamic_reconfigure::Server<syropod_highlevel_controller::DynamicConfig>* dynamic_reconfigure_server_;
 
-  std::shared_ptr<Model> model_;                     ///< Pointer to robot model object
-  std::shared_ptr<WalkController> walker_;           ///< Pointer to walk controller object
-  std::shared_ptr<PoseController> poser_;            ///< Pointer to pose controller object
-  std::shared_ptr<AdmittanceController> admittance_; ///< Pointer to admittance controller object
-  DebugVisualiser debug_visualiser_;                 ///< Debug class object used for RVIZ visualization
-  Parameters params_;                                ///< Parameter data structure for storing parameter variables
+  std::shared_ptr<Model> model_;                           ///< Pointer to robot model object
+  std::shared_ptr<WalkController> walker_;                 ///< Pointer to walk controller object
+  std::shared_ptr<PoseController> poser_;                  ///< Pointer to pose controller object
+  std::shared_ptr<AdmittanceController> admittance_;       ///< Pointer to admittance controller object
+  DebugVisualiser debug_visualiser_;                       ///< Debug class object used for RVIZ visualization
+  Parameters params_;                                      ///< Parameter data structure for storing parameter variables
+
+  std::vector<ExternalTarget, Eigen::aligned_allocator<ExternalTarget>> posted_targets_;  ///< Targets posted per leg
+  std::vector<ExternalTarget, Eigen::aligned_allocator<ExternalTarget>> posted_defaults_; ///< Defaults posted per leg
 
    bool initialised_ = false; ///< Flags if the state controller has initialised
 
@@ -332,6 +488,18 @@ private:
   RobotState new_robot_state_ = UNKNOWN;     ///< Desired state of the robot
 
   GaitDesignation gait_selection_ = GAIT_UNDESIGNATED;            ///< Current gait selection for the walk cycle
+
+  std::shared_ptr<LoopProfiler> loop_profiler_; ///< Pointer to control loop stage timing profiler
+
+  std::vector<GaitDefinition> gait_definitions_; ///< Step cycle timing of each gait defined in gait parameters
+
+  std::string auto_gait_type_;               ///< Name of a pending automatic gait selection, else empty
+  std::vector<GaitLimits> gait_limits_;      ///< Speed limit tables of each gait over the step frequency grid
+  LimitMap gait_limits_walkspace_;           ///< The walkspace from which the gait limit tables were generated
+  double gait_limits_step_frequency_ = 0.0;  ///< The step frequency grid minimum of the gait limit tables
+  int auto_gait_candidate_ = -1;             ///< Index of the current automatic gait selection in gait limit tables
+  int auto_gait_candidate_count_ = 0;        ///< Number of iterations the current automatic selection has persisted
+  double auto_gait_speed_ratio_ = 0.0;       ///< Proportion of speed limits used by the current automatic selection
   PosingMode posing_mode_ = NO_POSING;                            ///< Current posing mode for manual posing
   CruiseControlMode cruise_control_mode_ = CRUISE_CONTROL_OFF;    ///< Current cruise control mode
   PlannerMode planner_mode_ = PLANNER_MODE_OFF;                   ///< Current planner mode
@@ -356,6 +524,7 @@ private:
   bool parameter_adjust_flag_ = false;       ///< Flags that the selected parameter is being adjusted
   bool joint_positions_initialised_ = false; ///< Flags if all joint objects have been initialised with a position
   bool transition_state_flag_ = false;       ///< Flags that the system state is transitioning
+  bool fatal_error_ = false;                 ///< Flags that an unrecoverable error has occurred
 
   bool target_configuration_acquired_ = false; ///< Flag denoting if configuration has acquired from planner interface
   bool target_tip_pose_acquired_ = false;      ///< Flag denoting if tip pose has been acquired from planner interface
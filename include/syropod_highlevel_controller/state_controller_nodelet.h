@@ -0,0 +1,44 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_STATE_CONTROLLER_NODELET_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_STATE_CONTROLLER_NODELET_H
+
+#include "control_loop.h"
+
+#include <nodelet/nodelet.h>
+#include <thread>
+
+namespace syropod_highlevel_controller
+{
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Nodelet packaging of the state controller, as an alternative to the standalone node. Loaded into the same nodelet
+/// manager as perception, planner and hardware interface nodelets, messages published by shared pointer (e.g. joint
+/// states and tip states subscribed by the controller, or desired joint states and leg states published by the
+/// controller) are exchanged without serialisation. Subscribed topics are received by the threads of the nodelet
+/// manager whilst the controller runs on its own dedicated control thread, as per the standalone node.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class StateControllerNodelet : public nodelet::Nodelet
+{
+public:
+  /// Destructor for the state controller nodelet. Stops and joins the control thread.
+  ~StateControllerNodelet(void);
+
+private:
+  /// Initialisation of the nodelet. Creates the state controller and starts the control thread.
+  virtual void onInit(void);
+
+  std::shared_ptr<StateController> state_; ///< Pointer to the state controller
+  std::thread control_thread_;             ///< Dedicated thread running the state controller
+  std::atomic<bool> stop_{false};          ///< Flag which stops the control thread on unloading of the nodelet
+};
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_STATE_CONTROLLER_NODELET_H
@@ -0,0 +1,262 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_TELEMETRY_PUBLISHER_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_TELEMETRY_PUBLISHER_H
+
+#include "standard_includes.h"
+#include "parameters_and_states.h"
+#include "pose.h"
+#include "model.h"
+#include "gait_tables.h"
+#include "loop_profiler.h"
+
+#include "syropod_highlevel_controller/LegState.h"
+
+#include <atomic>
+#include <thread>
+
+#define MAX_JOINT_COUNT 8                                ///< Maximum number of joints per leg held in telemetry
+#define WALKSPACE_BEARING_COUNT (360 / BEARING_STEP + 1) ///< Number of bearings of the walkspace held in telemetry
+#define TELEMETRY_BUFFER_SIZE 8                          ///< Number of telemetry snapshots awaiting publishing
+
+#define LOOP_TIMING_PUBLISH_PERIOD 1.0 ///< Period between publishing of control loop stage timing statistics (seconds)
+#define ODOM_CHECK_PERIOD 0.5          ///< Period between checks for an odom transform from perception (seconds)
+#define ODOM_TIMEOUT 1.0               ///< Age after which the latest odom transform is no longer available (seconds)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Designation for telemetry topics, each published at a rate configured by the telemetry_rates parameter.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+enum TelemetryTopic
+{
+  LEG_STATE_TOPIC,           ///< Leg state of each leg - /shc/LEG_ID/state
+  VELOCITY_TOPIC,            ///< Desired body velocity - /shc/velocity
+  POSE_TOPIC,                ///< Current body pose - /shc/pose
+  WALKSPACE_TOPIC,           ///< Walkspace - /shc/walkspace
+  GAIT_SELECTION_TOPIC,      ///< Automatic gait selection - /shc/gait_selection
+  ODOMETRY_TOPIC,            ///< Ideal odometry - /shc/odometry
+  ROTATION_POSE_ERROR_TOPIC, ///< Imu posing errors - /shc/rotation_pose_error
+  FRAME_TRANSFORMS_TOPIC,    ///< Transforms of joint frames - /tf (odom_ideal and walk_plane sent every cycle)
+  TELEMETRY_TOPIC_COUNT,     ///< Misc enum defining number of Telemetry Topics
+};
+
+/// Returns the key of a telemetry topic within the telemetry_rates parameter.
+/// @param[in] topic The telemetry topic
+/// @return The parameter key of the telemetry topic
+std::string getTelemetryTopicName(const TelemetryTopic &topic);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Object containing the state of a single leg captured for telemetry. Fixed size, such that capture never allocates.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct LegTelemetry
+{
+  Pose walker_tip_pose_;                       ///< Desired tip pose from the walk controller (walk_plane frame)
+  Pose target_tip_pose_;                       ///< Target tip pose at end of swing period (walk_plane frame)
+  Pose poser_tip_pose_;                        ///< Desired tip pose from the pose controller (base_link frame)
+  Pose model_tip_pose_;                        ///< Desired tip pose finalised by the model (base_link frame)
+  Eigen::Vector3d model_tip_velocity_;         ///< Desired tip velocity finalised by the model
+  double desired_positions_[MAX_JOINT_COUNT];  ///< Desired position of each joint
+  double desired_velocities_[MAX_JOINT_COUNT]; ///< Desired velocity of each joint
+  double desired_efforts_[MAX_JOINT_COUNT];    ///< Desired effort of each joint
+  double current_positions_[MAX_JOINT_COUNT];  ///< Current position of each joint according to hardware
+  double swing_progress_;                      ///< Progress along swing state (-1 if not in swing)
+  double stance_progress_;                     ///< Progress along stance state (-1 if not in stance)
+  double time_to_swing_end_;                   ///< Time until completion of the swing period (seconds)
+  Pose pose_delta_;                            ///< Estimated change in walk plane pose until end of swing period
+  Pose auto_pose_;                             ///< Leg specific auto pose
+  Eigen::Vector3d tip_force_;                  ///< Tip force used in admittance control, scaled by force gain
+  Eigen::Vector3d admittance_delta_;           ///< Tip position offset from admittance control
+  double virtual_stiffness_;                   ///< Virtual stiffness used in admittance control
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Object containing the state of the robot captured for telemetry at the end of a control loop cycle.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct TelemetrySnapshot
+{
+  ros::Time time_;                            ///< The ros time of capture
+  bool running_;                              ///< Flag denoting if the robot was in the running state
+  Eigen::Vector2d desired_linear_velocity_;   ///< Desired linear body velocity
+  double desired_angular_velocity_;           ///< Desired angular body velocity
+  Pose current_pose_;                         ///< Current pose of base_link in walk_plane frame
+  Pose odometry_ideal_;                       ///< Ideal odometry (pose of walk_plane in odom_ideal frame)
+  Eigen::Matrix3d odometry_covariance_;       ///< Planar (x, y, yaw) covariance of ideal odometry
+  int walkspace_count_;                       ///< Number of bearings of the walkspace
+  double walkspace_[WALKSPACE_BEARING_COUNT]; ///< Walkspace radius at each bearing
+  bool gait_selection_defined_;               ///< Flag denoting if an automatic gait selection is defined
+  double gait_selection_[3];                  ///< Automatic gait designation, step frequency and speed ratio
+  Eigen::Vector3d rotation_absement_error_;   ///< Imu posing rotation absement error
+  Eigen::Vector3d rotation_position_error_;   ///< Imu posing rotation position error
+  Eigen::Vector3d rotation_velocity_error_;   ///< Imu posing rotation velocity error
+  LegTelemetry legs_[MAX_LEG_COUNT];          ///< State of each leg indexed by leg id number
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// This class publishes telemetry (leg states, body velocity/pose, walkspace, gait selection, odometry, posing errors,
+/// frame transforms and loop timing) on a separate low priority thread, removing message construction, serialisation
+/// and forward kinematics of actual joint positions from the control loop. The control loop captures snapshots into a
+/// preallocated ring buffer (single producer, single consumer) without locking. Snapshots captured whilst the buffer is
+/// full are dropped. Each topic is decimated to its configured rate and skipped entirely whilst it has no subscribers.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class TelemetryPublisher
+{
+public:
+  /// Constructor for the telemetry publisher. Advertises topics and starts the publisher thread. Must be constructed
+  /// from a thread with normal scheduling, which the publisher thread inherits. Flags a fatal error of the model if it
+  /// has more legs or joints than the snapshot storage holds.
+  /// @param[in] node_handle Node handle used to advertise telemetry topics
+  /// @param[in] model Pointer to the robot model object, from which constant leg names and kinematics are copied
+  /// @param[in] params Pointer to the parameter data structure
+  /// @param[in] transform_buffer The tf buffer used to check for an odom transform from perception
+  /// @param[in] loop_profiler Pointer to the control loop profiler from which loop timing is collected
+  TelemetryPublisher(ros::NodeHandle &node_handle, std::shared_ptr<Model> model, const Parameters &params,
+                     tf2_ros::Buffer &transform_buffer, std::shared_ptr<LoopProfiler> loop_profiler);
+
+  /// Destructor for the telemetry publisher. Stops and joins the publisher thread.
+  ~TelemetryPublisher(void);
+
+  /// Returns the next free snapshot of the ring buffer for writing by the control loop.
+  /// @return Pointer to the free snapshot, or null if the buffer is full
+  TelemetrySnapshot* beginCapture(void);
+
+  /// Releases the snapshot returned by the previous call to beginCapture() for publishing.
+  void endCapture(void);
+
+  /// Accessor for whether a transform to the odom frame (i.e. odometry from perception) exists on the tf tree.
+  /// @return Flag denoting if a recent odom transform was found by the latest odom availability check
+  inline bool isOdomAvailable(void) { return odom_available_.load(std::memory_order_relaxed); };
+
+private:
+  ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  /// Constant names and DH parameters of the kinematic chain of a leg, copied from the robot model on construction.
+  ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  struct LegChain
+  {
+    std::shared_ptr<Leg> leg_;             ///< Pointer to the leg object (used for its leg state publisher)
+    std::string name_;                     ///< Identification name of the leg
+    std::vector<std::string> frame_names_; ///< Identification names of each joint followed by the tip
+    std::vector<int> actuating_joints_;    ///< Index of the joint actuating each link (-1 if unactuated)
+    int joint_count_;                      ///< Number of joints of the leg
+    std::vector<Eigen::Vector4d, Eigen::aligned_allocator<Eigen::Vector4d>> dh_parameters_; ///< DH (d, theta, r, alpha)
+    std::vector<Pose, Eigen::aligned_allocator<Pose>> frame_offsets_; ///< Pose of each frame in parent at zero position
+
+  public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+
+  /// Publisher thread loop which publishes snapshots as they are captured.
+  void run(void);
+
+  /// Determines if a topic published at a fixed rate is due for publishing, and if so records the time of publishing.
+  /// Tolerates half a control loop period of jitter, such that rates dividing the control rate are not aliased.
+  /// @param[in] topic The telemetry topic
+  /// @param[in] time The time of the snapshot to be published
+  /// @return Flag denoting if the topic is due for publishing
+  bool isDue(const TelemetryTopic &topic, const ros::Time &time);
+
+  /// Checks, once per ODOM_CHECK_PERIOD, whether a transform from base_link to odom (i.e. odometry from perception)
+  /// newer than ODOM_TIMEOUT exists on the tf tree, without relying on exceptions. Odometry appearing or disappearing
+  /// at runtime switches the odom_ideal transform off or on respectively.
+  void updateOdomAvailability(void);
+
+  /// Calculates poses of each joint origin and the tip in the robot frame from joint positions.
+  /// @param[in] chain The kinematic chain of the leg
+  /// @param[in] joint_positions The position of each joint
+  /// @param[out] poses The pose of each joint origin followed by the tip
+  void applyFK(const LegChain &chain, const double* joint_positions,
+               std::vector<Pose, Eigen::aligned_allocator<Pose>> *poses);
+
+  /// Publishes leg state messages of each leg.
+  /// @param[in] snapshot The telemetry snapshot
+  void publishLegState(TelemetrySnapshot &snapshot);
+
+  /// Publishes desired linear and angular body velocity.
+  /// @param[in] snapshot The telemetry snapshot
+  void publishVelocity(TelemetrySnapshot &snapshot);
+
+  /// Publishes current pose (x, y, z, roll, pitch, yaw).
+  /// @param[in] snapshot The telemetry snapshot
+  void publishPose(TelemetrySnapshot &snapshot);
+
+  /// Publishes walkspace radius at each bearing whilst running. Publishes on change only if configured with zero rate.
+  /// @param[in] snapshot The telemetry snapshot
+  void publishWalkspace(TelemetrySnapshot &snapshot);
+
+  /// Publishes the current automatic gait selection (gait designation, step frequency and speed limit proportion).
+  /// Publishes on change only if configured with zero rate.
+  /// @param[in] snapshot The telemetry snapshot
+  void publishGaitSelection(TelemetrySnapshot &snapshot);
+
+  /// Publishes ideal odometry (pose of walk plane in odom_ideal frame) with covariance, and desired body velocity.
+  /// @param[in] snapshot The telemetry snapshot
+  void publishOdometry(TelemetrySnapshot &snapshot);
+
+  /// Publishes imu pose rotation absement, position and velocity errors used in the PID controller.
+  /// @param[in] snapshot The telemetry snapshot
+  void publishRotationPoseError(TelemetrySnapshot &snapshot);
+
+  /// Publishes transforms linking base_link with walk_plane, and with odom_ideal if no odom transform from perception
+  /// exists on the tf tree, for every snapshot (i.e. at the control loop rate) since external target lookups and odom
+  /// availability depend on them. Transforms of joint frames are published as a separate batch at the frame_transforms
+  /// telemetry rate. Each joint frame is published relative to the frame of the previous joint in the leg (base_link
+  /// for the first joint), such that tip frames are static and published once on construction.
+  /// @param[in] snapshot The telemetry snapshot
+  void publishFrameTransforms(TelemetrySnapshot &snapshot);
+
+  /// Publishes timing statistics (median, 99th percentile, maximum and overruns) of each control loop stage as
+  /// diagnostics, once per LOOP_TIMING_PUBLISH_PERIOD. Does nothing unless loop timing is enabled.
+  void publishLoopTiming(void);
+
+  ros::Publisher velocity_publisher_;            ///< Publisher for topic /shc/velocity
+  ros::Publisher pose_publisher_;                ///< Publisher for topic /shc/pose
+  ros::Publisher walkspace_publisher_;           ///< Publisher for topic /shc/walkspace
+  ros::Publisher rotation_pose_error_publisher_; ///< Publisher for topic /shc/rotation_pose_error
+  ros::Publisher gait_selection_publisher_;      ///< Publisher for topic /shc/gait_selection
+  ros::Publisher odometry_publisher_;            ///< Publisher for topic /shc/odometry
+  ros::Publisher loop_timing_publisher_;         ///< Publisher for topic /diagnostics
+
+  tf2_ros::Buffer &transform_buffer_;                                ///< The tf buffer shared with state controller
+  tf2_ros::TransformBroadcaster transform_broadcaster_;              ///< Broadcaster of frame transforms
+  tf2_ros::StaticTransformBroadcaster static_transform_broadcaster_; ///< Broadcaster of static tip frame transforms
+  std::vector<geometry_msgs::TransformStamped> body_transforms_;     ///< Batch of body frame transforms, reused
+  std::vector<geometry_msgs::TransformStamped> frame_transforms_;    ///< Batch of joint frame transforms, reused
+  std::atomic<bool> odom_available_;                                 ///< Flag denoting if odom transform exists on tf
+  std::chrono::steady_clock::time_point last_odom_check_;            ///< Time of the latest odom availability check
+
+  std::vector<LegChain, Eigen::aligned_allocator<LegChain>> leg_chains_; ///< Kinematic chain of each leg
+  std::vector<Pose, Eigen::aligned_allocator<Pose>> chain_poses_;        ///< Working storage for forward kinematics
+
+  double topic_rates_[TELEMETRY_TOPIC_COUNT];           ///< Maximum publishing rate of each topic (Hz, 0 = on change)
+  ros::Time last_publish_times_[TELEMETRY_TOPIC_COUNT]; ///< Time of the latest snapshot published on each topic
+  double published_walkspace_[WALKSPACE_BEARING_COUNT]; ///< Walkspace most recently published
+  int published_walkspace_count_ = 0;                   ///< Number of bearings of walkspace most recently published
+  double published_gait_selection_[3] = {};             ///< Automatic gait selection most recently published
+
+  std::shared_ptr<LoopProfiler> loop_profiler_;                    ///< Profiler of the control loop stages
+  std::shared_ptr<LoopProfiler> telemetry_profiler_;               ///< Profiler of the telemetry publishing stages
+  std::chrono::steady_clock::time_point last_loop_timing_publish_; ///< Time of the latest publishing of loop timing
+  std::string hardware_id_;                                        ///< Hardware id of loop timing diagnostics
+  double time_delta_;                                              ///< The period of the control loop (seconds)
+
+  std::unique_ptr<TelemetrySnapshot[]> snapshots_; ///< Ring buffer of snapshots (one slot always empty)
+  std::atomic<int> head_;                          ///< Index of the next snapshot to be captured
+  std::atomic<int> tail_;                          ///< Index of the next snapshot to be published
+  std::atomic<unsigned long> dropped_count_;       ///< Number of snapshots dropped whilst the ring buffer was full
+  std::atomic<bool> shutdown_;                     ///< Flags that the publisher thread should exit
+  std::thread thread_;                             ///< The publisher thread
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_TELEMETRY_PUBLISHER_H
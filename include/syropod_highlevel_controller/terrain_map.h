@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_TERRAIN_MAP_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_TERRAIN_MAP_H
+
+#include "standard_includes.h"
+#include "parameters_and_states.h"
+
+#define TERRAIN_MAP_TILE_SIZE 16  ///< Number of cells along each axis of a single terrain map tile
+#define TERRAIN_MAP_TILE_COUNT 8  ///< Number of tiles along each axis of the terrain map ring buffer
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Object containing terrain height data of a single cell of the terrain map.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct TerrainMapCell
+{
+  int x_index_ = 0;      ///< Global x index of the cell in the odom_ideal frame
+  int y_index_ = 0;      ///< Global y index of the cell in the odom_ideal frame
+  double height_ = 0.0;  ///< The height of the stepping surface within the cell in the odom_ideal frame
+  bool defined_ = false; ///< Flag denoting if the cell has been assigned a height
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// This class maintains a local 2.5D height map of the stepping surface about the robot, anchored in the odom_ideal
+/// frame. Heights are populated from touchdown positions and tip state step plane estimates and queried when
+/// generating swing targets, such that trailing legs may proactively target ground found by leading legs. Cells are
+/// stored in a fixed size ring buffer indexed by global cell index, so insertion and query are constant time and the
+/// map rolls with the robot without reallocation. Cells are grouped into contiguous square tiles so neighbouring
+/// cells generally share cache lines.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class TerrainMap
+{
+public:
+  /// Constructor for the terrain map.
+  /// @param[in] params A reference to the parameter data structure
+  TerrainMap(const Parameters &params);
+
+  /// Clears all cells of the terrain map.
+  void clear(void);
+
+  /// Updates the height of the cell containing the input position, overwriting any previous height.
+  /// @param[in] position The position on the stepping surface in the odom_ideal frame
+  void updateHeight(const Eigen::Vector3d &position);
+
+  /// Returns the height of the cell containing the input position.
+  /// @param[in] position The position in the odom_ideal frame (height component ignored)
+  /// @return The height of the stepping surface in the odom_ideal frame or UNASSIGNED_VALUE if unknown
+  double getHeight(const Eigen::Vector3d &position);
+
+private:
+  /// Returns a reference to the ring buffer cell which holds the input global cell indices.
+  /// @param[in] x_index The global x index of the cell
+  /// @param[in] y_index The global y index of the cell
+  /// @return Reference to the ring buffer cell
+  TerrainMapCell &getCell(const int &x_index, const int &y_index);
+
+  const Parameters &params_;        ///< Reference to parameter data structure for storing parameter variables
+  std::vector<TerrainMapCell> map_; ///< Ring buffer of terrain map cells in tiled layout
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_TERRAIN_MAP_H
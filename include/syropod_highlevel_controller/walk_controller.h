@@ -13,8 +13,20 @@
 #include "parameters_and_states.h"
 #include "pose.h"
 #include "model.h"
+#include "external_target.h"
+
+#define GAIT_TRANSITION_CYCLES 2 ///< Number of step cycles over which phase is corrected during on-the-fly gait changes
+#define CADENCE_SPEED_RATIO 0.8  ///< Proportion of max speed at which cadence mode aims to walk for a given frequency
+#define ODOMETRY_LINEAR_NOISE 0.01       ///< Variance of ideal odometry position added per metre travelled (m^2/m)
+#define ODOMETRY_ANGULAR_NOISE 0.01      ///< Variance of ideal odometry yaw added per radian turned (rad^2/rad)
+#define KINEMATIC_ODOMETRY_NOISE 1.0e-8  ///< Variance of kinematic odometry change per cycle from a single stance leg
+#define STANCE_NODE_TOLERANCE 1.0e-9     ///< Tolerance in spacing of stance control nodes for linear stance (m)
+#define SWING_OPTIMISER_ITERATIONS 20    ///< Number of projection iterations used in swing apex optimisation
+#define SWING_OPTIMISER_TOLERANCE 1.0e-3 ///< Tolerance in constraint satisfaction of optimised swing apex (m)
 
 class DebugVisualiser;
+class FootstepPlanner;
+class TerrainMap;
 typedef std::map<int, double> LimitMap;
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -32,19 +44,6 @@ struct StepCycle
   int stance_start_;  ///< The iteration at which the stance period starts
 };
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// Object containing parameters which define an externally set target tip pose.
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-struct ExternalTarget
-{
-  Pose pose_;              ///< The target tip pose
-  double swing_clearance_; ///< The height of the swing trajectory clearance normal to walk plane
-  std::string frame_id_;   ///< The target tip pose reference frame id
-  ros::Time time_;         ///< The ros time of the request for the target tip pose
-  Pose transform_;         ///< The transform between reference frames at time of request and current time
-  bool defined_ = false;   ///< Flag denoting if external target object has been defined
-};
-
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// This class handles top level management of the walk cycle state machine and calls each leg's LegStepper object to
 /// update tip trajectories. This class also handles generation of default walk stance tip positions, calculation of
@@ -95,9 +94,13 @@ public:
   /// @return Walk cycle state
   inline WalkState getWalkState(void) { return walk_state_; };
 
+  /// Accessor for flag denoting if the walk cycle is currently transitioning between gaits.
+  /// @return Flag denoting if the walk cycle is currently transitioning between gaits
+  inline bool isTransitioningGait(void) { return gait_transition_; };
+
   /// Accessor for walkspace.
   /// @return Walkspace
-  inline LimitMap getWalkspace(void) { return walkspace_; };
+  inline const LimitMap& getWalkspace(void) { return walkspace_; };
 
   /// Accessor for walk plane estimate.
   /// @return Walk plane estimate
@@ -111,6 +114,18 @@ public:
   /// @return Ideal odometry pose
   inline Pose getOdometryIdeal(void) { return odometry_ideal_; };
 
+  /// Accessor for the covariance of the ideal odometry pose in the walk plane.
+  /// @return Covariance matrix of ideal odometry (x, y, yaw)
+  inline Eigen::Matrix3d getOdometryCovariance(void) { return odometry_covariance_; };
+
+  /// Accessor for the footstep planner object.
+  /// @return Pointer to the footstep planner object
+  inline std::shared_ptr<FootstepPlanner> getFootstepPlanner(void) { return footstep_planner_; };
+
+  /// Accessor for the terrain height map object.
+  /// @return Pointer to the terrain height map object
+  inline std::shared_ptr<TerrainMap> getTerrainMap(void) { return terrain_map_; };
+
   /// Accessor for model current pose.
   /// @return Model current pose
   inline Pose getModelCurrentPose(void) { return model_->getCurrentPose(); };
@@ -150,18 +165,39 @@ public:
   /// Generate maximum linear and angular speed/acceleration for each workspace radius in workspace map from a given
   /// step cycle. These calculated values will accomodate overshoot of tip outside defined workspace whilst body
   /// accelerates, effectively scaling usable workspace. The calculated values are either set as walk controller limits
-  /// OR output to given pointer arguments.
+  /// OR output to given pointer arguments. Limits are a closed-form scaling of walkspace radii, so output to pointer
+  /// arguments is cheap and leaves leg phase offsets untouched, allowing evaluation of candidate step cycles.
   /// @param[in] step Step cycle timing object
+  /// @param[in] gait_table The step cycle timing of the gait from which the step cycle was generated
   /// @param[out] max_linear_speed_ptr Pointer to output object to store new maximum linear speed values
   /// @param[out] max_angular_speed_ptr Pointer to output object to store new maximum angular speed values
   /// @param[out] max_linear_acceleration_ptr Pointer to output object to store new maximum linear acceleration values
   /// @param[out] max_angular_acceleration_ptr Pointer to output object to store new maximum angular acceleration values
   void generateLimits(StepCycle step,
+                      const GaitTable &gait_table,
                       LimitMap *max_linear_speed_ptr = NULL,
                       LimitMap *max_angular_speed_ptr = NULL,
                       LimitMap *max_linear_acceleration_ptr = NULL,
                       LimitMap *max_angular_acceleration_ptr = NULL);
 
+  /// Generate maximum linear and angular speed/acceleration for each workspace radius in workspace map from a given
+  /// step cycle of the current gait. The calculated values are either set as walk controller limits OR output to given
+  /// pointer arguments.
+  /// @param[in] step Step cycle timing object
+  /// @param[out] max_linear_speed_ptr Pointer to output object to store new maximum linear speed values
+  /// @param[out] max_angular_speed_ptr Pointer to output object to store new maximum angular speed values
+  /// @param[out] max_linear_acceleration_ptr Pointer to output object to store new maximum linear acceleration values
+  /// @param[out] max_angular_acceleration_ptr Pointer to output object to store new maximum angular acceleration values
+  inline void generateLimits(StepCycle step,
+                             LimitMap *max_linear_speed_ptr = NULL,
+                             LimitMap *max_angular_speed_ptr = NULL,
+                             LimitMap *max_linear_acceleration_ptr = NULL,
+                             LimitMap *max_angular_acceleration_ptr = NULL)
+  {
+    generateLimits(step, params_.gait_table, max_linear_speed_ptr, max_angular_speed_ptr,
+                   max_linear_acceleration_ptr, max_angular_acceleration_ptr);
+  };
+
   /// Generate maximum linear and angular speed/acceleration for each workspace radius in workspace map from pre-set
   /// step cycle. These calculated values will accomodate overshoot of tip outside defined workspace whilst body
   /// accelerates, effectively scaling usable workspace. The calculated values are either set as walk controller limits
@@ -179,11 +215,44 @@ public:
                    max_linear_acceleration_ptr, max_angular_acceleration_ptr);
   };
 
+  /// Generates step timing object from walk cycle parameters, normalising base parameters according to a given step
+  /// frequency. Returns step timing object and optionally sets step timing in Walk Controller.
+  /// @param[in] step_frequency The desired step frequency from which to generate the step cycle
+  /// @param[in] set_step_cycle Flag denoting if generated step cycle object is to be set in Walk Controller
+  /// @return Generated step cycle object
+  StepCycle generateStepCycle(const double &step_frequency, const bool set_step_cycle);
+
+  /// Generates step timing object from the input gait timing, normalising base timing according to a given step
+  /// frequency. Leaves the walk controller untouched, allowing evaluation of step cycles of candidate gaits.
+  /// @param[in] step_frequency The desired step frequency from which to generate the step cycle
+  /// @param[in] gait_table The step cycle timing of the gait
+  /// @return Generated step cycle object
+  StepCycle generateStepCycle(const double &step_frequency, const GaitTable &gait_table);
+
   /// Generates step timing object from walk cycle parameters, normalising base parameters according to step frequency.
   /// Returns step timing object and optionally sets step timing in Walk Controller.
   /// @param[in] set_step_cycle Flag denoting if generated step cycle object is to be set in Walk Controller
   /// @return Generated step cycle object
-  StepCycle generateStepCycle(const bool set_step_cycle = true);
+  inline StepCycle generateStepCycle(const bool set_step_cycle = true)
+  {
+    return generateStepCycle(params_.step_frequency.current_value, set_step_cycle);
+  };
+
+  /// Begins a transition from the current gait to the gait currently defined in parameters without stopping the walk
+  /// cycle. Each leg phase is mapped into the new step cycle and the phase error to the new gait's phase offsets is
+  /// corrected over GAIT_TRANSITION_CYCLES step cycles by stretching or shortening stance periods. Velocity and
+  /// acceleration limits are set to the minimum of both gaits until the transition is complete, with velocity limits
+  /// further reduced such that stretched stance periods cover no more than the nominal stride at those limits.
+  void beginGaitTransition(void);
+
+  /// Adapts the step frequency of the walk cycle whilst walking for 'continuous' and 'cadence' step frequency modes.
+  /// The target frequency is either the step_frequency parameter or, in cadence mode, a frequency between the
+  /// step_frequency parameter and its maximum value scaled according to commanded speed. Increases in frequency are
+  /// applied immediately. Decreases step down to the lowest frequency whose limits accommodate the current desired
+  /// velocity, whilst velocity is restricted to the limits of the target frequency. Leg phases are rescaled in place.
+  /// @param[in] linear_velocity_input The velocity input given to the Syropod defining desired linear body motion
+  /// @param[in] angular_velocity_input The velocity input given to the Syropod defining desired angular body motion
+  void updateStepFrequency(const Eigen::Vector2d &linear_velocity_input, const double &angular_velocity_input);
 
   /// Given an input linear velocity vector and angular velocity, this function calculates a stride bearing then
   /// an interpolation of the two limits at the bearings (defined by the input limit map) bounding the stride bearing.
@@ -195,6 +264,13 @@ public:
   double getLimit(const Eigen::Vector2d &linear_velocity_input, const double &angular_velocity_input,
                   const LimitMap &limit);
 
+  /// Interpolates the two limits at the bearings (defined by the input limit map) bounding the bearing of the input
+  /// direction, e.g. the walkspace radius in the direction of an offset from the default tip position.
+  /// @param[in] limit The LimitMap object which contains limit data for a range of bearings from 0-360 degrees
+  /// @param[in] direction The direction vector in the walk plane from which the bearing is calculated
+  /// @return The interpolated limit at the bearing of the input direction
+  double interpolateLimit(const LimitMap &limit, const Eigen::Vector2d &direction);
+
   /// Updates all legs in the walk cycle. Calculates stride vectors for all legs from robot body velocity inputs and
   /// calls trajectory update functions for each leg to update individual tip positions. Also manages the overall walk
   /// state via state machine and input velocities as well as the individual step state of each leg as they progress
@@ -203,6 +279,33 @@ public:
   /// @param[in] angular_velocity_input An input for the desired angular velocity of the robot body about the z axis
   void updateWalk(const Eigen::Vector2d &linear_velocity_input, const double &angular_velocity_input);
 
+  /// Updates the walk cycle state machine. Transitions are driven by the velocity command and by counters of leg
+  /// coordination which are updated on step cycle events of each leg, rather than by checking every leg each cycle.
+  /// Entry actions of a new walk state are applied to each leg once upon transition.
+  /// @param[in] has_velocity_command Flag denoting if a non-zero body velocity is commanded
+  /// @return Flag denoting if the walk state transitioned to STARTING, skipping iteration of phase for this cycle
+  bool updateWalkState(const bool &has_velocity_command);
+
+  /// Handles the event of a leg reaching the start of its swing period.
+  /// @param[in] leg A pointer to the leg object
+  void handleSwingStart(std::shared_ptr<Leg> leg);
+
+  /// Handles the event of a leg reaching the end of its swing period, updating leg coordination counters according to
+  /// the current walk state.
+  /// @param[in] leg A pointer to the leg object
+  void handleSwingEnd(std::shared_ptr<Leg> leg);
+
+  /// Ends the swing period of a leg early if touchdown is detected during the second half of swing. Only applied
+  /// whilst moving and once any previous phase correction of the leg is complete, such that each leg deviates from its
+  /// phase offset by at most half a swing period and has restored its phase offset before its next swing.
+  /// @param[in] leg A pointer to the leg object
+  void handleEarlyTouchdown(std::shared_ptr<Leg> leg);
+
+  /// Sets the state of the input leg, maintaining the count of legs in WALKING state used to allow walking.
+  /// @param[in] leg A pointer to the leg object
+  /// @param[in] leg_state The new state of the leg
+  void setLegState(std::shared_ptr<Leg> leg, const LegState &leg_state);
+
   /// Updates the tip position for legs in the manual state from tip velocity inputs. Two modes are available: joint
   /// control allows manipulation of joint positions directly but only works for 3DOF legs; tip control allows
   /// manipulation of the tip in cartesian space in the robot frame.
@@ -228,15 +331,30 @@ public:
   /// Ref: https://math.stackexchange.com/questions/99299/best-fitting-plane-given-a-set-of-points
   void updateWalkPlane(void);
 
+  /// Records the height of the step plane estimate of the input leg in the terrain height map, if defined.
+  /// @param[in] leg A pointer to the leg object
+  void updateTerrainMap(std::shared_ptr<Leg> leg);
+
   /// Estimates the acceleration vector due to gravity.
   /// @return The estimated acceleration vector due to gravity
   inline Eigen::Vector3d estimateGravity(void) { return model_->estimateGravity(); };
 
   /// Calculates the change in pose over the desired time period assuming constant desired body velocity and walk plane.
+  /// The body follows the exact circular arc of constant linear and angular velocity in the walk plane.
   /// @param[in] time_period The period of time for which to estimate the odometry pose change
   /// @return The estimated odometry pose change over the desired time period
   Pose calculateOdometry(const double &time_period);
 
+  /// Calculates the change in pose of the walk plane frame since the previous iteration from the actual tip positions
+  /// (forward kinematics of measured joint positions) of legs which remain in stance.
+  /// @param[out] stance_leg_count The number of stance legs used in the estimate
+  /// @return The estimated odometry pose change since the previous iteration
+  Pose calculateKinematicOdometry(int &stance_leg_count);
+
+  /// Iterates ideal odometry by the change in pose over a single iteration, optionally fused with the kinematic
+  /// estimate from legs in stance, and propagates the covariance of the odometry estimate.
+  void updateOdometry(void);
+
 private:
   std::shared_ptr<Model> model_; ///< Pointer to robot model object
   const Parameters &params_;     ///< Pointer to parameter data structure for storing parameter variables
@@ -247,6 +365,9 @@ private:
 
   StepCycle step_; ///< Step cycle timing object
 
+  std::shared_ptr<FootstepPlanner> footstep_planner_; ///< Pointer to the footstep planner object
+  std::shared_ptr<TerrainMap> terrain_map_;           ///< Pointer to the terrain height map object
+
   // Workspace generation variables
   LimitMap walkspace_;                ///< A map of interpolated radii for given bearings in degrees at default stance
   Eigen::Vector3d walk_plane_;        ///< The co-efficients of an estimated planar walk surface
@@ -261,10 +382,19 @@ private:
   LimitMap max_angular_speed_;              ///< A map of max allowable angular speeds for potential bearings
   LimitMap max_linear_acceleration_;        ///< A map of max allowable linear accelerations for potential bearings
   LimitMap max_angular_acceleration_;       ///< A map of max allowable angular accelerations for potential bearings
+  bool gait_transition_ = false;            ///< Flag denoting if the walk cycle is transitioning between gaits
+  bool frequency_transition_ = false;       ///< Flag denoting if the walk cycle is stepping down to a target frequency
+  LimitMap target_max_linear_speed_;        ///< A map of max linear body speeds at the target step frequency
+  LimitMap target_max_angular_speed_;       ///< A map of max angular speeds at the target step frequency
+
+  // Odometry variables
+  Eigen::Matrix3d odometry_covariance_;                 ///< The covariance of the ideal odometry (x, y, yaw)
+  std::map<int, Eigen::Vector3d> stance_tip_positions_; ///< Actual tip positions of legs in stance at last iteration
 
   // Leg coordination variables
   int legs_at_correct_phase_ = 0;            ///< A count of legs currently at the correct phase per walk cycle state
   int legs_completed_first_step_ = 0;        ///< A count of legs whcih have currently completed their first step
+  int legs_walking_ = 0;                     ///< A count of legs currently in WALKING state
   bool return_to_default_attempted_ = false; ///< Flags whether a leg has already attempted to return to default
 
   // Iteration variables
@@ -340,6 +470,10 @@ public:
   /// @return Current phase offset of the step cycle
   inline int getPhaseOffset(void) { return phase_offset_; };
 
+  /// Accessor for the number of iterations of phase correction remaining (positive: advance, negative: delay).
+  /// @return Number of iterations of phase correction remaining
+  inline int getPhaseCorrection(void) { return phase_correction_; };
+
   /// Accessor for the current stride vector used in the step cycle.
   /// @return Current stride vector used in the step cycle
   inline Eigen::Vector3d getStrideVector(void) { return stride_vector_; };
@@ -420,6 +554,16 @@ public:
   /// @param[in] phase_offset The new phase offset
   inline void setPhaseOffset(const int &phase_offset) { phase_offset_ = phase_offset; };
 
+  /// Modifier for the phase correction applied during the stance period of upcoming step cycles.
+  /// @param[in] phase_correction The number of iterations to advance (positive) or delay (negative) the phase
+  /// @param[in] interval The number of stance iterations between each single iteration of phase correction
+  inline void setPhaseCorrection(const int &phase_correction, const int &interval = 1)
+  {
+    phase_correction_ = phase_correction;
+    phase_correction_interval_ = std::max(1, interval);
+    phase_correction_count_ = 0;
+  };
+
   /// Modifier for the flag denoting if the leg has completed its first step.
   /// @param[in] completed_first_step The new value for the flag
   inline void setCompletedFirstStep(const bool &completed_first_step) { completed_first_step_ = completed_first_step; };
@@ -443,9 +587,27 @@ public:
   /// Updates phase for new step cycle parameters.
   void updatePhase(void);
 
-  /// Iterates the step phase and updates the progress variables.
+  /// Iterates the step phase and updates the progress variables. Any outstanding phase correction is applied by
+  /// holding or skipping a phase iteration within the stance period.
   void iteratePhase(void);
 
+  /// Truncates the swing period by setting the phase to the start of the stance period. The truncated iterations are
+  /// set as phase correction which delays the following stance period by an equal number of iterations, restoring the
+  /// phase offset of the leg relative to the step cycle. If the tip would leave the walkspace over the extended stance
+  /// period, the stance velocity of the tip is reduced to keep the stroke of an unextended stance period.
+  void truncateSwing(void);
+
+  /// Maps the current phase from a previous step cycle into the current step cycle, preserving the normalised progress
+  /// through the swing or stance period.
+  /// @param[in] previous_step The step cycle timing object from which the current phase is mapped
+  void mapPhase(const StepCycle &previous_step);
+
+  /// Rescales the current phase from a previous step cycle of the same gait but differing step frequency into the
+  /// current step cycle. Phase is scaled within each normalised segment of the base step cycle, preserving relative
+  /// phase between legs and never returning a leg to the first iteration of a swing/stance period already begun.
+  /// @param[in] previous_step The step cycle timing object from which the current phase is rescaled
+  void rescalePhase(const StepCycle &previous_step);
+
   /// Updates the Step state of this LegStepper according to the phase.
   void updateStepState(void);
 
@@ -482,6 +644,24 @@ public:
   /// for STARTING state of walker
   void generateStanceControlNodes(const double &stride_scaler);
 
+  /// Returns true if the stance control nodes are collinear and evenly spaced, in which case the stance bezier curve
+  /// has constant velocity and the tip position may be updated linearly rather than by evaluating the curve.
+  /// @return Flag denoting if the stance control nodes define a constant velocity stance trajectory
+  bool isLinearStance(void);
+
+  /// Returns true if the stance period may be extended by the given number of iterations without the tip leaving the
+  /// walkspace, predicting the tip position at stance end from the current position and (scaled) stride vector.
+  /// @param[in] extension The number of iterations by which the remaining stance period would be extended
+  /// @return Flag denoting if the extended stance period keeps the tip within the walkspace
+  bool isStanceExtensionPermitted(const int &extension);
+
+  /// Optimises the apex of the swing trajectory (the shared control node of the primary and secondary swing bezier
+  /// curves) for minimum integrated squared jerk over the swing period. All other control nodes are fixed by C0/C1/C2
+  /// boundary conditions at swing origin and target, reducing the problem to a 3d quadratic program which is solved as
+  /// the projection of the unconstrained optimum onto constraints of minimum clearance above the terrain height map and
+  /// maximum tip speed per the joint angular speed limits.
+  void optimiseSwingApex(void);
+
   /// Updates control nodes for quartic bezier curves of both halves of swing tip trajectory calculation to force the
   /// trajectory of the touchdown period of the swing period to be normal to the walk plane.
   void forceNormalTouchdown(void);
@@ -497,6 +677,12 @@ private:
   int phase_ = 0;    ///< Step cycle phase
   int phase_offset_; ///< Step cycle phase offset
 
+  int phase_correction_ = 0;          ///< Iterations of phase correction remaining (positive: advance, negative: delay)
+  int phase_correction_interval_ = 1; ///< Number of stance iterations between each iteration of phase correction
+  int phase_correction_count_ = 0;    ///< Count of stance iterations since the last iteration of phase correction
+
+  double stance_velocity_scaler_ = 1.0; ///< Scaler of stance tip velocity, reduced whilst stance is extended
+
   double step_progress_ = 0.0;    ///< The progress of the entire step cycle (0.0->1.0 || -1.0)
   double swing_progress_ = -1.0;  ///< The progress of the swing period in the step cycle. (0.0->1.0 || -1.0)
   double stance_progress_ = -1.0; ///< The progress of the stance period in the step cycle. (0.0->1.0 || -1.0)
@@ -506,11 +692,13 @@ private:
   Eigen::Vector3d swing_1_nodes_[5]; ///< An array of 3d control nodes defining the primary swing bezier curve
   Eigen::Vector3d swing_2_nodes_[5]; ///< An array of 3d control nodes defining the secondary swing bezier curve
   Eigen::Vector3d stance_nodes_[5];  ///< An array of 3d control nodes defining the stance bezier curve
+  bool linear_stance_ = false;       ///< Flag denoting if stance control nodes define a constant velocity curve
 
-  Eigen::Vector3d walk_plane_;        ///< A saved version of the estimated walk plane which is kept static during swing
-  Eigen::Vector3d walk_plane_normal_; ///< The normal of the saved estimated planar walk surface
-  Eigen::Vector3d stride_vector_;     ///< The desired stride vector
-  Eigen::Vector3d swing_clearance_;   ///< Position relative to the default tip position to achieve during swing period
+  Eigen::Vector3d walk_plane_;          ///< A saved version of the estimated walk plane kept static during swing
+  Eigen::Vector3d walk_plane_normal_;   ///< The normal of the saved estimated planar walk surface
+  Eigen::Vector3d stride_vector_;       ///< The desired stride vector
+  Eigen::Vector3d swing_clearance_;     ///< Position relative to the default tip position to achieve during swing
+  Eigen::Vector3d swing_apex_position_; ///< Optimised tip position at transition between primary and secondary swing
 
   double swing_delta_t_ = 0.0;
   double stance_delta_t_ = 0.0;
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_WORKER_POOL_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_WORKER_POOL_H
+
+#include "standard_includes.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// This class maintains a fixed pool of worker threads, each pinned to a separate CPU core, over which a set of
+/// independent tasks is distributed. The calling thread also executes tasks and only returns once all tasks of the set
+/// are complete, such that the tasks may safely reference state of the caller. Workers run under the scheduling policy
+/// and priority of the thread which creates the pool, so a real-time caller is never left waiting on lower priority
+/// workers. Used to execute the independent per-leg updates of each control cycle in parallel.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class WorkerPool
+{
+public:
+  /// Constructor for the worker pool. Starts worker threads with the scheduling policy and priority of the calling
+  /// thread, pinned to cores other than the excluded core.
+  /// @param[in] thread_count The number of worker threads (in addition to the calling thread)
+  /// @param[in] excluded_core The CPU core of the calling thread, left free of workers (-1 = core 0)
+  WorkerPool(const int &thread_count, const int &excluded_core = -1);
+
+  /// Destructor for the worker pool. Stops and joins worker threads.
+  ~WorkerPool(void);
+
+  /// Accessor for the number of worker threads.
+  /// @return The number of worker threads (in addition to the calling thread)
+  inline int getThreadCount(void) { return static_cast<int>(threads_.size()); };
+
+  /// Executes the input task for each task index across the worker threads and calling thread, returning once the task
+  /// has completed for every index. Tasks must be independent of one another.
+  /// @param[in] task_count The number of tasks, with each task given an index from zero to task_count - 1
+  /// @param[in] task The task function which takes the task index as input
+  void execute(const int &task_count, const std::function<void(int)> &task);
+
+private:
+  /// Worker thread loop which waits for and executes each set of tasks.
+  /// @param[in] core The CPU core to which the worker thread is pinned
+  /// @param[in] policy The scheduling policy of the worker thread
+  /// @param[in] priority The scheduling priority of the worker thread
+  void work(const int core, const int policy, const int priority);
+
+  /// Executes tasks of the current set until none remain unclaimed.
+  void executeTasks(void);
+
+  std::vector<std::thread> threads_;          ///< Worker threads
+  std::mutex mutex_;                          ///< Mutex protecting task set and worker state
+  std::condition_variable start_condition_;   ///< Condition signalling workers that a new task set is available
+  std::condition_variable finish_condition_;  ///< Condition signalling caller that all workers have finished
+
+  const std::function<void(int)>* task_ = NULL; ///< Task function of the current task set
+  int task_count_ = 0;                          ///< Number of tasks in the current task set
+  std::atomic<int> next_task_;                  ///< Index of the next unclaimed task of the current task set
+  int active_workers_ = 0;                      ///< Number of workers yet to finish the current task set
+  unsigned long generation_ = 0;                ///< Identifier of the current task set
+  bool shutdown_ = false;                       ///< Flags that worker threads should exit
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_WORKER_POOL_H
@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SYROPOD_HIGHLEVEL_CONTROLLER_YAML_PARAMETERS_H
+#define SYROPOD_HIGHLEVEL_CONTROLLER_YAML_PARAMETERS_H
+
+#include "parameters_and_states.h"
+
+#include <yaml-cpp/yaml.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Converts a YAML node into an XmlRpc value, with scalar types resolved as per loading via rosparam.
+/// @param[in] node The YAML node
+/// @return The equivalent XmlRpc value
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline XmlRpc::XmlRpcValue convertYAML(const YAML::Node &node)
+{
+  XmlRpc::XmlRpcValue value;
+  if (node.IsSequence())
+  {
+    value.setSize(node.size());
+    for (std::size_t i = 0; i < node.size(); ++i)
+    {
+      value[int(i)] = convertYAML(node[i]);
+    }
+  }
+  else if (node.IsMap())
+  {
+    for (YAML::const_iterator it = node.begin(); it != node.end(); ++it)
+    {
+      value[it->first.as<std::string>()] = convertYAML(it->second);
+    }
+  }
+  else if (node.IsScalar())
+  {
+    int int_value;
+    double double_value;
+    bool bool_value;
+    // Quoted scalars are always strings
+    if (node.Tag() == "!")
+    {
+      value = node.as<std::string>();
+    }
+    else if (YAML::convert<int>::decode(node, int_value))
+    {
+      value = int_value;
+    }
+    else if (YAML::convert<double>::decode(node, double_value))
+    {
+      value = double_value;
+    }
+    else if (YAML::convert<bool>::decode(node, bool_value))
+    {
+      value = bool_value;
+    }
+    else
+    {
+      value = node.as<std::string>();
+    }
+  }
+  return value;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Adds a YAML node and (recursively) each of its members to the local parameter store.
+/// @param[in] node The YAML node
+/// @param[in] name The full parameter name of the node
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline void loadParameters(const YAML::Node &node, const std::string &name)
+{
+  getLocalParameters()[name] = convertYAML(node);
+  if (node.IsMap())
+  {
+    for (YAML::const_iterator it = node.begin(); it != node.end(); ++it)
+    {
+      loadParameters(it->second, name + "/" + it->first.as<std::string>());
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Loads config files into the local parameter store, as per loading each file via rosparam.
+/// @param[in] config_files The paths of the config files
+/// @return Flag denoting if all config files were successfully loaded
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline bool loadConfigFiles(const std::vector<std::string> &config_files)
+{
+  for (const std::string &config_file : config_files)
+  {
+    try
+    {
+      YAML::Node root = YAML::LoadFile(config_file);
+      for (YAML::const_iterator it = root.begin(); it != root.end(); ++it)
+      {
+        loadParameters(it->second, "/" + it->first.as<std::string>());
+      }
+    }
+    catch (const YAML::Exception &e)
+    {
+      fprintf(stderr, "Failed to load config file %s: %s\n", config_file.c_str(), e.what());
+      return false;
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // SYROPOD_HIGHLEVEL_CONTROLLER_YAML_PARAMETERS_H
@@ -0,0 +1,217 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syropod_highlevel_controller/control_loop.h"
+
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void configureConsoleVerbosity(const Parameters &params)
+{
+  bool set_logger_level_result = false;
+
+  if (params.console_verbosity.data == std::string("debug"))
+  {
+    set_logger_level_result = ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Debug);
+  }
+  else if (params.console_verbosity.data == "info")
+  {
+    set_logger_level_result = ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Info);
+  }
+  else if (params.console_verbosity.data == "warning")
+  {
+    set_logger_level_result = ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Warn);
+  }
+  else if (params.console_verbosity.data == "error")
+  {
+    set_logger_level_result = ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Error);
+  }
+  else if (params.console_verbosity.data == "fatal")
+  {
+    set_logger_level_result = ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Fatal);
+  }
+
+  if (set_logger_level_result)
+  {
+    ros::console::notifyLoggerLevelsChanged();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void configureControlThread(const Parameters &params)
+{
+  int priority = params.control_thread_priority.data;
+  if (priority > 0)
+  {
+    sched_param scheduling_parameters;
+    scheduling_parameters.sched_priority = priority;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &scheduling_parameters) != 0)
+    {
+      ROS_WARN("\n[SHC] Unable to set real-time priority %d for control thread (requires rtprio privileges).\n",
+               priority);
+    }
+  }
+
+  int core = params.control_thread_core.data;
+  if (core >= 0)
+  {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core, &cpu_set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) != 0)
+    {
+      ROS_WARN("\n[SHC] Unable to pin control thread to CPU core %d.\n", core);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void runControlLoop(StateController *state, const std::atomic<bool> &stop)
+{
+  const Parameters& params = state->getParameters();
+  configureControlThread(params);
+  state->getModel()->initWorkerPool();
+
+  // Simulated time (e.g. Gazebo) must be followed by the ros rate rather than the monotonic clock
+  bool use_sim_time = ros::Time::isSimTime();
+  ros::Rate r(roundToInt(1.0 / params.time_delta.data));
+  long period = roundToInt(params.time_delta.data * NANOSECONDS_PER_SECOND);
+  timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+  while (ros::ok() && !stop && !state->hasFatalError())
+  {
+    {
+      ScopedStageTimer timer(*state->getLoopProfiler(), LOOP_STAGE);
+      state->processInputs();
+
+      if (state->getSystemState() != SUSPENDED)
+      {
+        state->loop();
+        state->publishDesiredJointState();
+        state->publishTelemetry();
+
+        if (params.debug_rviz.data)
+        {
+          state->RVIZDebugging();
+        }
+      }
+      else
+      {
+        ROS_INFO_THROTTLE(THROTTLE_PERIOD, "\nController suspended. Press Logitech button to resume . . .\n");
+      }
+    }
+
+    // Sleep until next cycle deadline
+    if (use_sim_time)
+    {
+      r.sleep();
+    }
+    else
+    {
+      deadline.tv_nsec += period;
+      while (deadline.tv_nsec >= static_cast<long>(NANOSECONDS_PER_SECOND))
+      {
+        deadline.tv_nsec -= static_cast<long>(NANOSECONDS_PER_SECOND);
+        deadline.tv_sec++;
+      }
+
+      timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      if (now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_nsec > deadline.tv_nsec))
+      {
+        ROS_WARN_THROTTLE(THROTTLE_PERIOD, "\n[SHC] Control loop overran cycle period of %f seconds.\n",
+                          params.time_delta.data);
+        deadline = now;
+      }
+      else
+      {
+        int result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+        while (result == EINTR)
+        {
+          result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void runController(StateController *state, const std::atomic<bool> &stop)
+{
+  const Parameters& params = state->getParameters();
+
+  // Set ros rate from params
+  ros::Rate r(roundToInt(1.0 / params.time_delta.data));
+
+  // Wait specified time to aquire all published joint positions via callback
+  int spin = static_cast<int>(ACQUISTION_TIME / params.time_delta.data); // Spin cycles from time
+  while (spin-- && ros::ok() && !stop)
+  {
+    ROS_INFO_THROTTLE(THROTTLE_PERIOD, "\nAcquiring robot state . . .\n");
+    // End wait if joints are intitialised or debugging in rviz (joint states will never initialise)
+    if (state->jointPositionsInitialised())
+    {
+      spin = 0;
+    }
+    state->processInputs();
+    r.sleep();
+  }
+
+  // Set start message
+  std::string start_message;
+  bool use_default_joint_positions;
+  if (state->jointPositionsInitialised())
+  {
+    start_message = "\nPress 'Logitech' button to start controller . . .\n";
+    use_default_joint_positions = false;
+  }
+  else
+  {
+    start_message = "\nPress 'Logitech' button to run controller initialising unknown positions to defaults . . .\n";
+    use_default_joint_positions = true;
+  }
+
+  // Loop waiting for start button press
+  while (state->getSystemState() == SUSPENDED && ros::ok() && !stop)
+  {
+    if (use_default_joint_positions)
+    {
+      ROS_WARN_THROTTLE(THROTTLE_PERIOD, "\nFailed to initialise joint position values!\n");
+    }
+    ROS_INFO_THROTTLE(THROTTLE_PERIOD, "%s", start_message.c_str());
+    state->processInputs();
+    r.sleep();
+  }
+
+  if (!ros::ok() || stop || state->hasFatalError())
+  {
+    return;
+  }
+
+  ROS_INFO("\nController started. Press START/BACK buttons to transition state of robot.\n");
+
+  state->init(); // Must be initialised before initialising model with current joint state
+  if (state->hasFatalError())
+  {
+    return;
+  }
+  state->initModel(use_default_joint_positions);
+
+  // Run control loop on this (dedicated) thread until ros shutdown (or fatal error)
+  runControlLoop(state, stop);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
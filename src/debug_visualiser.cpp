@@ -11,9 +11,15 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-DebugVisualiser::DebugVisualiser(void)
+DebugVisualiser::DebugVisualiser(std::shared_ptr<ros::NodeHandle> node_handle)
 {
-  ros::NodeHandle n;
+  // Running headless (without a ros master) so no visualisation is published
+  if (!node_handle)
+  {
+    return;
+  }
+
+  ros::NodeHandle &n = *node_handle;
   robot_model_publisher_ = n.advertise<visualization_msgs::Marker>("/shc/debug/robot_model", 1000);
   tip_trajectory_publisher_ = n.advertise<visualization_msgs::Marker>("/shc/debug/tip_trajectories", 1000);
   bezier_curve_publisher_ = n.advertise<visualization_msgs::Marker>("/shc/debug/bezier_curves", 1000);
@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syropod_highlevel_controller/external_target.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Registry of interned frame names. Frame names are only appended (under mutex) and published by the frame count.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct FrameRegistry
+{
+  std::string frame_names_[MAX_FRAME_ID_COUNT] = { "odom_ideal" }; ///< Registered frame names indexed by frame id
+  std::atomic<int> frame_count_{1};                                ///< Number of registered frame names
+  std::mutex mutex_;                                               ///< Mutex serialising registration of frame names
+};
+
+/// Returns the registry of interned frame names.
+/// @return Reference to the frame registry
+FrameRegistry& getFrameRegistry(void)
+{
+  static FrameRegistry frame_registry;
+  return frame_registry;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int internFrameID(const std::string &frame_name)
+{
+  if (frame_name.empty())
+  {
+    return UNDEFINED_FRAME_ID;
+  }
+
+  // Search published frame names without locking
+  FrameRegistry &registry = getFrameRegistry();
+  int count = registry.frame_count_.load(std::memory_order_acquire);
+  for (int i = 0; i < count; ++i)
+  {
+    if (registry.frame_names_[i] == frame_name)
+    {
+      return i;
+    }
+  }
+
+  // Register new frame name, searching again in case of concurrent registration
+  std::lock_guard<std::mutex> lock(registry.mutex_);
+  count = registry.frame_count_.load(std::memory_order_relaxed);
+  for (int i = 0; i < count; ++i)
+  {
+    if (registry.frame_names_[i] == frame_name)
+    {
+      return i;
+    }
+  }
+  if (count == MAX_FRAME_ID_COUNT)
+  {
+    ROS_ERROR_THROTTLE(THROTTLE_PERIOD, "\n[SHC] Unable to register frame '%s'. Maximum of %d frames registered.\n",
+                       frame_name.c_str(), MAX_FRAME_ID_COUNT);
+    return UNDEFINED_FRAME_ID;
+  }
+  registry.frame_names_[count] = frame_name;
+  registry.frame_count_.store(count + 1, std::memory_order_release);
+  return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const std::string &getFrameName(const int &frame_id)
+{
+  static const std::string undefined_frame_name;
+  FrameRegistry &registry = getFrameRegistry();
+  if (frame_id < 0 || frame_id >= registry.frame_count_.load(std::memory_order_acquire))
+  {
+    return undefined_frame_name;
+  }
+  return registry.frame_names_[frame_id];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
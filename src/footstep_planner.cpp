@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syropod_highlevel_controller/footstep_planner.h"
+#include "syropod_highlevel_controller/walk_controller.h"
+#include "syropod_highlevel_controller/terrain_map.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+FootstepPlanner::FootstepPlanner(std::shared_ptr<WalkController> walker, const Parameters &params)
+    : walker_(walker)
+    , params_(params)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FootstepPlanner::planFootsteps(std::shared_ptr<Leg> leg)
+{
+  std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
+  std::deque<Eigen::Vector3d> &footsteps = footsteps_[leg->getIDNumber()];
+  StepCycle step = walker_->getStepCycle();
+  const LimitMap &walkspace = walker_->getWalkspace();
+  double time_delta = walker_->getTimeDelta();
+  double search_distance = sqrt(2.0) * FOOTSTEP_SEARCH_CELLS * params_.footstep_planning_resolution.data;
+  int horizon = std::max(params_.footstep_planning_horizon.data, 1);
+
+  // Remove footstep of previous swing period
+  if (!footsteps.empty())
+  {
+    footsteps.pop_front();
+  }
+
+  // Discard footsteps from the first which no longer lies within search grid of its nominal touchdown position
+  Eigen::Vector3d nominal_position = leg_stepper->getDefaultTipPose().position_ + 0.5 * leg_stepper->getStrideVector();
+  for (int i = 0; i < int(footsteps.size()); ++i)
+  {
+    double time_to_touchdown = (step.swing_period_ + i * step.period_) * time_delta;
+    Eigen::Vector3d nominal_footstep = predictWalkPlanePose(time_to_touchdown).transformVector(nominal_position);
+    Eigen::Vector3d error = footsteps[i] - nominal_footstep;
+    if (Eigen::Vector2d(error[0], error[1]).norm() > search_distance)
+    {
+      footsteps.resize(i);
+      break;
+    }
+  }
+
+  // Extend plan to horizon
+  while (int(footsteps.size()) < horizon)
+  {
+    double time_to_touchdown = (step.swing_period_ + footsteps.size() * step.period_) * time_delta;
+    footsteps.push_back(generateFootstep(leg, predictWalkPlanePose(time_to_touchdown), walkspace));
+  }
+  footsteps.resize(horizon);
+
+  // Set next footstep as target unless an external target has been requested
+  ExternalTarget external_target = leg_stepper->getExternalTarget();
+  if (!external_target.defined_ || external_target.planned_)
+  {
+    ExternalTarget planned_target;
+    planned_target.pose_ = Pose(footsteps.front(), Eigen::Quaterniond::Identity());
+    planned_target.swing_clearance_ = walker_->getStepClearance();
+    planned_target.frame_id_ = ODOM_IDEAL_FRAME_ID;
+    planned_target.time_ = ros::Time::now();
+    planned_target.transform_ = Pose::Identity(); // Planned targets are transformed from odometry in-process
+    planned_target.defined_ = true;
+    planned_target.planned_ = true;
+    leg_stepper->setExternalTarget(planned_target);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Eigen::Vector3d FootstepPlanner::generateFootstep(std::shared_ptr<Leg> leg,
+                                                  const Pose &touchdown_pose,
+                                                  const LimitMap &walkspace)
+{
+  std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
+  Eigen::Vector3d default_position = leg_stepper->getDefaultTipPose().position_;
+  Eigen::Vector3d stride_vector = leg_stepper->getStrideVector();
+  Eigen::Vector3d nominal_position = default_position + 0.5 * stride_vector;
+  double resolution = params_.footstep_planning_resolution.data;
+
+  // Search grid about nominal position (in walk plane frame at touchdown) for lowest cost feasible footstep
+  Eigen::Vector3d footstep = nominal_position;
+  double min_cost = UNASSIGNED_VALUE;
+  for (int i = -FOOTSTEP_SEARCH_CELLS; i <= FOOTSTEP_SEARCH_CELLS; ++i)
+  {
+    for (int j = -FOOTSTEP_SEARCH_CELLS; j <= FOOTSTEP_SEARCH_CELLS; ++j)
+    {
+      double cost = FOOTSTEP_OFFSET_COST * (i * i + j * j);
+      if (cost >= min_cost)
+      {
+        continue;
+      }
+
+      // Touchdown and end of following stance period must lie within walkspace and tip within leg workspace
+      Eigen::Vector3d candidate = nominal_position + Eigen::Vector3d(i * resolution, j * resolution, 0.0);
+      if (!isWithinWalkspace(candidate - default_position, walkspace) ||
+          !isWithinWalkspace(candidate - stride_vector - default_position, walkspace) ||
+          (leg->makeReachable(candidate) - candidate).norm() > IK_TOLERANCE)
+      {
+        continue;
+      }
+
+      cost += getTerrainCost(touchdown_pose.transformVector(candidate));
+      if (cost < min_cost)
+      {
+        min_cost = cost;
+        footstep = candidate;
+      }
+    }
+  }
+  return touchdown_pose.transformVector(footstep);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool FootstepPlanner::isWithinWalkspace(const Eigen::Vector3d &offset, const LimitMap &walkspace)
+{
+  Eigen::Vector2d planar_offset(offset[0], offset[1]);
+  return planar_offset.norm() <= walker_->interpolateLimit(walkspace, planar_offset);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Pose FootstepPlanner::predictWalkPlanePose(const double &time_period)
+{
+  return walker_->getOdometryIdeal().addPose(walker_->calculateOdometry(time_period));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double FootstepPlanner::getTerrainCost(const Eigen::Vector3d &position)
+{
+  double height = walker_->getTerrainMap()->getHeight(position);
+  return (height != UNASSIGNED_VALUE) ? abs(height - position[2]) / params_.swing_height.current_value : 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syropod_highlevel_controller/loop_profiler.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string getUpdateStageName(const UpdateStage &stage)
+{
+  static const char* stage_names[UPDATE_STAGE_COUNT] = {
+    "walk", "pose", "model", "current_pose", "admittance",
+    "publish_leg_state", "publish_velocity", "publish_pose", "publish_walkspace", "publish_gait_selection",
+    "publish_odometry", "publish_rotation_pose_error", "publish_frame_transforms", "publish_desired_joint_state",
+    "rviz_debugging", "loop",
+  };
+  return (stage >= 0 && stage < UPDATE_STAGE_COUNT) ? stage_names[stage] : "undefined";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StageHistogram::StageHistogram(void)
+  : overrun_count_(0)
+  , max_nanoseconds_(0)
+{
+  for (int i = 0; i < TIMING_BUCKET_COUNT; ++i)
+  {
+    bucket_counts_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StageHistogram::record(const double &duration, const bool &overrun)
+{
+  int bucket = 0;
+  if (duration > TIMING_BUCKET_MINIMUM)
+  {
+    bucket = static_cast<int>(std::ceil(std::log2(duration / TIMING_BUCKET_MINIMUM) * TIMING_BUCKETS_PER_OCTAVE));
+    bucket = std::min(bucket, TIMING_BUCKET_COUNT - 1);
+  }
+  bucket_counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+
+  if (overrun)
+  {
+    overrun_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Maximum may be concurrently reset by collection, hence compare and swap
+  long nanoseconds = static_cast<long>(duration * 1.0e9);
+  long max_nanoseconds = max_nanoseconds_.load(std::memory_order_relaxed);
+  while (nanoseconds > max_nanoseconds)
+  {
+    if (max_nanoseconds_.compare_exchange_weak(max_nanoseconds, nanoseconds, std::memory_order_relaxed))
+    {
+      break;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StageStatistics StageHistogram::collect(void)
+{
+  StageStatistics statistics;
+  unsigned long window_counts[TIMING_BUCKET_COUNT];
+  for (int i = 0; i < TIMING_BUCKET_COUNT; ++i)
+  {
+    unsigned long bucket_count = bucket_counts_[i].load(std::memory_order_relaxed);
+    window_counts[i] = bucket_count - collected_bucket_counts_[i];
+    collected_bucket_counts_[i] = bucket_count;
+    statistics.count += window_counts[i];
+  }
+
+  unsigned long overrun_count = overrun_count_.load(std::memory_order_relaxed);
+  statistics.overrun_count = overrun_count - collected_overrun_count_;
+  collected_overrun_count_ = overrun_count;
+  statistics.max = max_nanoseconds_.exchange(0, std::memory_order_relaxed) / 1.0e9;
+
+  // Find upper bound of buckets containing percentiles
+  unsigned long p50_rank = (statistics.count + 1) / 2;
+  unsigned long p99_rank = static_cast<unsigned long>(std::ceil(statistics.count * 0.99));
+  unsigned long cumulative_count = 0;
+  for (int i = 0; i < TIMING_BUCKET_COUNT && statistics.count > 0; ++i)
+  {
+    unsigned long previous_count = cumulative_count;
+    cumulative_count += window_counts[i];
+    double upper_bound = TIMING_BUCKET_MINIMUM * std::pow(2.0, static_cast<double>(i) / TIMING_BUCKETS_PER_OCTAVE);
+    if (previous_count < p50_rank && cumulative_count >= p50_rank)
+    {
+      statistics.p50 = std::min(upper_bound, statistics.max);
+    }
+    if (previous_count < p99_rank && cumulative_count >= p99_rank)
+    {
+      statistics.p99 = std::min(upper_bound, statistics.max);
+    }
+  }
+
+  return statistics;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+LoopProfiler::LoopProfiler(const bool &enabled, const double &period)
+  : enabled_(enabled)
+  , period_(period)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LoopProfiler::record(const UpdateStage &stage, const double &duration)
+{
+  latest_durations_[stage] = duration;
+  histograms_[stage].record(duration, duration > period_);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
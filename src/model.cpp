@@ -63,6 +63,16 @@ void Model::generate(std::shared_ptr<Model> model)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void Model::initWorkerPool(void)
+{
+  if (params_.leg_update_threads.data > 0 && worker_pool_ == NULL)
+  {
+    worker_pool_ = std::make_shared<WorkerPool>(params_.leg_update_threads.data, params_.control_thread_core.data);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void Model::initLegs(const bool &use_default_joint_positions)
 {
   LegContainer::iterator leg_it;
@@ -142,12 +152,29 @@ void Model::generateWorkspaces(void)
 void Model::updateModel(void)
 {
   // Model uses posed tip positions, adds deltaZ from admittance controller and applies inverse kinematics on each leg
-  LegContainer::iterator leg_it;
-  for (leg_it = leg_container_.begin(); leg_it != leg_container_.end(); ++leg_it)
+  updateLegs([](std::shared_ptr<Leg> leg)
   {
-    std::shared_ptr<Leg> leg = leg_it->second;
     leg->setDesiredTipPose();
     leg->applyIK();
+  });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Model::updateLegs(const std::function<void(std::shared_ptr<Leg>)> &update)
+{
+  if (worker_pool_ == NULL)
+  {
+    LegContainer::iterator leg_it;
+    for (leg_it = leg_container_.begin(); leg_it != leg_container_.end(); ++leg_it)
+    {
+      update(leg_it->second);
+    }
+  }
+  else
+  {
+    worker_pool_->execute(static_cast<int>(leg_container_.size()),
+                          [&](int i) { update(std::next(leg_container_.begin(), i)->second); });
   }
 }
 
@@ -498,8 +525,7 @@ Workspace Leg::generateWorkspace(void)
       std::shared_ptr<DebugVisualiser> debug = model_->getDebugVisualiser();
       debug->generateRobotModel(model_);
       debug->generateWorkspace(shared_from_this(), params_.body_clearance.data);
-      ros::Rate r(100);
-      ros::spinOnce();
+      ros::Rate r(100); // Subscribed topics are received by the asynchronous spinner so no spin required
       r.sleep();
     }
     if (workspace_generation_complete)
@@ -553,34 +579,38 @@ Workplane Leg::getWorkplane(const double &height)
 
 Eigen::Vector3d Leg::makeReachable(const Eigen::Vector3d &reference_tip_position)
 {
-  // Get workplane containing test tip position
+  // Get test tip position relative to identity tip position, about which workplane radii are defined
   Pose pose = model_->getCurrentPose();
   Eigen::Vector3d test_tip_position = pose.inverseTransformVector(reference_tip_position);
-  Eigen::Vector3d identity_tip_position = leg_stepper_->getIdentityTipPose().position_;
+  Eigen::Vector3d identity_tip_position = pose.inverseTransformVector(leg_stepper_->getIdentityTipPose().position_);
   Eigen::Vector3d identity_to_test = test_tip_position - identity_tip_position;
   double distance_to_test = Eigen::Vector2d(identity_to_test[0], identity_to_test[1]).norm();
-  LimitMap workplane = getWorkplane(test_tip_position[2]);
 
-  // Find distance to workplane limit along bearing to test tip position
-  double raw_bearing = atan2(test_tip_position[1], test_tip_position[0]);
+  // Get workplane containing test tip position, limiting height to within workspace (unless workspace is a single
+  // workplane which applies at all heights)
+  double height = identity_to_test[2];
+  Workplane workplane = workspace_.begin()->second;
+  if (workspace_.size() > 1)
+  {
+    height = clamped(height, workspace_.begin()->first, workspace_.rbegin()->first);
+    workplane = getWorkplane(height);
+  }
+
+  // Find distance to workplane limit along bearing from identity tip position to test tip position
+  double raw_bearing = atan2(identity_to_test[1], identity_to_test[0]);
   int bearing = mod(roundToInt(radiansToDegrees(raw_bearing)), 360);
   int upper_bound = workplane.lower_bound(bearing)->first;
-  int lower_bound = mod(upper_bound - BEARING_STEP, 360);
-  bearing += (bearing < lower_bound) ? 360 : 0;
-  upper_bound += (upper_bound < lower_bound) ? 360 : 0;
-  double interpolation_progress = (bearing - lower_bound) / (upper_bound - lower_bound);
-  double distance_to_limit = interpolate(workplane.at(lower_bound),
-                                         workplane.at(mod(upper_bound, 360)),
-                                         interpolation_progress);
-
-  // If test tip position is beyond limit, calculate new position along same workplane bearing within limits
-  if (distance_to_test > distance_to_limit)
+  int lower_bound = (upper_bound == bearing ? bearing : upper_bound - BEARING_STEP);
+  double interpolation_progress = double(bearing - lower_bound) / BEARING_STEP;
+  double distance_to_limit = interpolate(workplane.at(lower_bound), workplane.at(upper_bound), interpolation_progress);
+
+  // If test tip position is beyond limits, calculate new position along same workplane bearing within limits
+  if (distance_to_test > distance_to_limit || height != identity_to_test[2])
   {
-    Eigen::Vector3d new_tip_position =
-        Eigen::AngleAxisd(raw_bearing, Eigen::Vector3d::UnitZ()) * (Eigen::Vector3d::UnitX() * distance_to_limit);
-    new_tip_position[2] = test_tip_position[2];
-    new_tip_position = pose.transformVector(new_tip_position);
-    return new_tip_position;
+    Eigen::Vector3d new_tip_position = Eigen::AngleAxisd(raw_bearing, Eigen::Vector3d::UnitZ()) *
+                                       (Eigen::Vector3d::UnitX() * std::min(distance_to_test, distance_to_limit));
+    new_tip_position[2] = height;
+    return pose.transformVector(identity_tip_position + new_tip_position);
   }
   else
   {
@@ -602,18 +632,33 @@ void Leg::updateDefaultConfiguration(void)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void Leg::generateDesiredJointStateMsg(sensor_msgs::JointState *joint_state_msg)
+void Leg::initDesiredJointStateMsg(sensor_msgs::JointState *joint_state_msg)
 {
-  joint_state_msg->header.stamp = ros::Time::now();
   JointContainer::iterator joint_it;
   for (joint_it = joint_container_.begin(); joint_it != joint_container_.end(); ++joint_it)
   {
     std::shared_ptr<Joint> joint = joint_it->second;
     joint_state_msg->name.push_back(joint->id_name_);
-    joint_state_msg->position.push_back(joint->desired_position_);
-    joint_state_msg->velocity.push_back(joint->desired_velocity_);
-    joint_state_msg->effort.push_back(joint->desired_effort_);
+    joint_state_msg->position.push_back(0.0);
+    joint_state_msg->velocity.push_back(0.0);
+    joint_state_msg->effort.push_back(0.0);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int Leg::updateDesiredJointStateMsg(sensor_msgs::JointState *joint_state_msg, const int &index)
+{
+  int i = index;
+  JointContainer::iterator joint_it;
+  for (joint_it = joint_container_.begin(); joint_it != joint_container_.end(); ++joint_it, ++i)
+  {
+    std::shared_ptr<Joint> joint = joint_it->second;
+    joint_state_msg->position[i] = joint->desired_position_;
+    joint_state_msg->velocity[i] = joint->desired_velocity_;
+    joint_state_msg->effort[i] = joint->desired_effort_;
   }
+  return i;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -913,12 +958,14 @@ double Leg::applyIK(const bool &simulation)
 
   // Display warning messages for associated inverse kinematic deviations
   std::string axis_label[3] = {"x", "y", "z"};
+  bool deviation = false;
   for (int i = 0; i < 3; ++i)
   {
     Eigen::Vector3d position_error = current_tip_pose_.position_ - desired_tip_pose_.position_;
     if (abs(position_error[i]) > IK_TOLERANCE)
     {
       ik_success = 0.0;
+      deviation = true;
       ROS_WARN_COND(!simulation && !params_.ignore_IK_warnings.data,
                     "\nInverse kinematics deviation! Calculated tip %s position of leg %s (%s: %f)"
                     " differs from desired tip position (%s: %f)\n",
@@ -934,6 +981,11 @@ double Leg::applyIK(const bool &simulation)
     desired_tip_pose_.rotation_ = UNDEFINED_ROTATION;
     ik_success = applyIK(simulation);
   }
+  // Count deviations unless retrying (which counts any deviation itself)
+  else if (deviation && !simulation)
+  {
+    ik_deviation_count_++;
+  }
 
   calculateTipForce();
 
@@ -989,6 +1041,31 @@ Pose Leg::applyFK(const bool &set_current, const bool &use_actual)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+Pose Leg::calculateActualTipPose(void) const
+{
+  // Chain transforms from actual joint positions - first joint transform is constant so taken from model
+  JointContainer::const_iterator joint_it = joint_container_.begin();
+  Eigen::Matrix4d transform = joint_it->second->getTransformFromJoint();
+  for (++joint_it; joint_it != joint_container_.end(); ++joint_it)
+  {
+    const std::shared_ptr<Link> reference_link = joint_it->second->reference_link_;
+    transform = transform * createDHMatrix(reference_link->dh_parameter_d_,
+                                           reference_link->dh_parameter_theta_ +
+                                           reference_link->actuating_joint_->current_position_,
+                                           reference_link->dh_parameter_r_,
+                                           reference_link->dh_parameter_alpha_);
+  }
+  const std::shared_ptr<Link> reference_link = tip_->reference_link_;
+  transform = transform * createDHMatrix(reference_link->dh_parameter_d_,
+                                         reference_link->dh_parameter_theta_ +
+                                         reference_link->actuating_joint_->current_position_,
+                                         reference_link->dh_parameter_r_,
+                                         reference_link->dh_parameter_alpha_);
+  return Pose::Identity().transform(transform);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 Link::Link(std::shared_ptr<Leg> leg, std::shared_ptr<Joint> actuating_joint,
            const int &id_number, const Parameters &params)
     : parent_leg_(leg)
@@ -1003,7 +1080,7 @@ Link::Link(std::shared_ptr<Leg> leg, std::shared_ptr<Joint> actuating_joint,
   if (!params.link_parameters[leg->getIDNumber()][id_number_].initialised)
   {
     ROS_FATAL("\nModel initialisation error for %s\n", id_name_.c_str());
-    ros::shutdown();
+    leg->getModel()->setFatalError();
   }
 }
 
@@ -1068,7 +1145,7 @@ Joint::Joint(std::shared_ptr<Leg> leg, std::shared_ptr<Link> reference_link,
   else
   {
     ROS_FATAL("\nModel initialisation error for %s\n", id_name_.c_str());
-    ros::shutdown();
+    leg->getModel()->setFatalError();
   }
 }
 
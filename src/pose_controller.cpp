@@ -50,7 +50,7 @@ void PoseController::setAutoPoseParams(void)
   // Calculate posing phase length and normalisation values based off gait/posing cycle parameters
   if (pose_frequency_ == -1.0) // Use step cycle parameters
   {
-    base_phase_length = params_.stance_phase.data + params_.swing_phase.data;
+    base_phase_length = params_.gait_table.base_step_period;
     double swing_ratio = double(params_.swing_phase.data) / base_phase_length;
     raw_phase_length = ((1.0 / params_.step_frequency.current_value) / params_.time_delta.data) / swing_ratio;
   }
@@ -72,7 +72,7 @@ void PoseController::setAutoPoseParams(void)
     leg_poser->setNegationTransitionRatio(params_.negation_transition_ratio.data.at(leg->getIDName()));
 
     // Set reference leg for auto posing system to that which has zero phase offset
-    if (params_.offset_multiplier.data.at(leg->getIDName()) == 0)
+    if (params_.gait_table.phase_offsets[leg->getIDNumber()] == 0)
     {
       auto_pose_reference_leg_ = leg;
     }
@@ -438,7 +438,7 @@ int PoseController::executeSequence(const SequenceSelection& sequence)
   if (transition_step_ > TRANSITION_STEP_THRESHOLD)
   {
     ROS_FATAL("\nUnable to execute sequence, shutting down controller.\n");
-    ros::shutdown();
+    model_->setFatalError();
   }
 
   // Check if sequence has completed
@@ -1228,7 +1228,7 @@ void PoseController::updateIMUPose(void)
   if (rotation_correction.norm() > STABILITY_THRESHOLD)
   {
     ROS_FATAL("IMU rotation compensation became unstable! Adjust PID parameters.\n");
-    ros::shutdown();
+    model_->setFatalError();
   }
 
   imu_pose_.rotation_ = eulerAnglesToQuaternion(rotation_correction);
@@ -0,0 +1,150 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syropod_highlevel_controller/shared_memory_interface.h"
+
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+SharedMemoryInterface::SharedMemoryInterface(std::shared_ptr<Model> model, const std::string &name)
+  : name_(name)
+{
+  // Joints are held in order of leg then joint, as per the combined desired joint state message
+  for (LegContainer::iterator leg_it = model->getLegContainer()->begin();
+       leg_it != model->getLegContainer()->end(); ++leg_it)
+  {
+    std::shared_ptr<Leg> leg = leg_it->second;
+    JointContainer::iterator joint_it;
+    for (joint_it = leg->getJointContainer()->begin(); joint_it != leg->getJointContainer()->end(); ++joint_it)
+    {
+      joints_.push_back(joint_it->second);
+    }
+  }
+
+  if (joints_.size() > SHARED_MEMORY_MAX_JOINTS)
+  {
+    ROS_ERROR("\n[SHC] Unable to create shared memory interface, model has more than %d joints.\n",
+              SHARED_MEMORY_MAX_JOINTS);
+    return;
+  }
+
+  file_descriptor_ = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0660);
+  if (file_descriptor_ < 0)
+  {
+    ROS_ERROR("\n[SHC] Unable to create shared memory segment %s (%s).\n", name_.c_str(), strerror(errno));
+    return;
+  }
+
+  // Remove the segment just created (and its descriptor) if it cannot be sized or mapped
+  void* address = MAP_FAILED;
+  if (ftruncate(file_descriptor_, sizeof(SharedMemoryLayout)) != 0)
+  {
+    ROS_ERROR("\n[SHC] Unable to size shared memory segment %s (%s).\n", name_.c_str(), strerror(errno));
+  }
+  else
+  {
+    address = mmap(NULL, sizeof(SharedMemoryLayout), PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor_, 0);
+    ROS_ERROR_COND(address == MAP_FAILED, "\n[SHC] Unable to map shared memory segment %s (%s).\n",
+                   name_.c_str(), strerror(errno));
+  }
+  if (address == MAP_FAILED)
+  {
+    shm_unlink(name_.c_str());
+    close(file_descriptor_);
+    file_descriptor_ = -1;
+    return;
+  }
+
+  // Reinitialise segment (which may remain from a previous run), publishing version only once joint names are set
+  layout_ = new (address) SharedMemoryLayout();
+  layout_->joint_count_ = joints_.size();
+  for (uint i = 0; i < joints_.size(); ++i)
+  {
+    strncpy(layout_->joint_names_[i], joints_[i]->id_name_.c_str(), SHARED_MEMORY_NAME_LENGTH - 1);
+  }
+  layout_->version_.store(SHARED_MEMORY_VERSION, std::memory_order_release);
+  ROS_INFO("\n[SHC] Shared memory hardware interface created at %s for %d joints.\n",
+           name_.c_str(), layout_->joint_count_);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+SharedMemoryInterface::~SharedMemoryInterface(void)
+{
+  if (layout_)
+  {
+    // Wake driver (if waiting on commands) such that it observes the closed segment
+    layout_->version_.store(0, std::memory_order_release);
+    beginBlockWrite(&layout_->command_);
+    endBlockWrite(&layout_->command_);
+    munmap(layout_, sizeof(SharedMemoryLayout));
+    shm_unlink(name_.c_str());
+  }
+  if (file_descriptor_ >= 0)
+  {
+    close(file_descriptor_);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void SharedMemoryInterface::writeCommand(void)
+{
+  if (!layout_)
+  {
+    return;
+  }
+
+  JointStateBlock* command = &layout_->command_;
+  beginBlockWrite(command);
+  command->data_.stamp_ = getMonotonicTime();
+  command->data_.velocity_valid_ = true;
+  command->data_.effort_valid_ = true;
+  for (uint i = 0; i < joints_.size(); ++i)
+  {
+    std::shared_ptr<Joint> joint = joints_[i];
+    command->data_.position_[i] = joint->desired_position_;
+    command->data_.velocity_[i] = joint->desired_velocity_;
+    command->data_.effort_[i] = joint->desired_effort_;
+  }
+  endBlockWrite(command);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool SharedMemoryInterface::readState(void)
+{
+  uint32_t sequence;
+  if (!layout_ || !readBlock(&layout_->state_, &state_data_, &sequence) || sequence == state_sequence_)
+  {
+    return false;
+  }
+  state_sequence_ = sequence;
+
+  // Assign state as per joint state topic callback
+  for (uint i = 0; i < joints_.size(); ++i)
+  {
+    std::shared_ptr<Joint> joint = joints_[i];
+    joint->current_position_ = state_data_.position_[i] - joint->offset_;
+    if (state_data_.velocity_valid_)
+    {
+      joint->current_velocity_ = state_data_.velocity_[i];
+    }
+    if (state_data_.effort_valid_)
+    {
+      joint->current_effort_ = state_data_.effort_[i];
+      joint->desired_effort_ = joint->current_effort_; // HACK
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
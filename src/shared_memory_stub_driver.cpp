@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syropod_highlevel_controller/shared_memory_layout.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <vector>
+
+#define REPORT_PERIOD 1.0e9        ///< Period between latency reports (nanoseconds)
+#define CONNECT_PERIOD 500000      ///< Period between attempts to open the shared memory segment (microseconds)
+#define COMMAND_TIMEOUT_SECONDS 1  ///< Max time waiting for a command before checking the segment is still open
+
+volatile std::sig_atomic_t running = 1; ///< Flag cleared on interrupt to exit the driver
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Maps the shared memory segment created by the controller, waiting until it exists and has been initialised.
+/// @param[in] name The name of the POSIX shared memory segment
+/// @return Pointer to the mapped shared memory segment, or NULL if interrupted
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+SharedMemoryLayout* openSegment(const std::string &name)
+{
+  while (running)
+  {
+    int file_descriptor = shm_open(name.c_str(), O_RDWR, 0);
+    if (file_descriptor >= 0)
+    {
+      void* address = mmap(NULL, sizeof(SharedMemoryLayout), PROT_READ | PROT_WRITE, MAP_SHARED, file_descriptor, 0);
+      close(file_descriptor);
+      if (address != MAP_FAILED)
+      {
+        SharedMemoryLayout* layout = static_cast<SharedMemoryLayout*>(address);
+        if (layout->version_.load(std::memory_order_acquire) == SHARED_MEMORY_VERSION)
+        {
+          return layout;
+        }
+        munmap(address, sizeof(SharedMemoryLayout));
+      }
+    }
+    usleep(CONNECT_PERIOD);
+  }
+  return NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Stub hardware driver for testing the shared memory hardware interface without hardware. Sleeps on the command block
+/// and echoes each desired joint state back as the current joint state (i.e. perfect actuators), reporting latency
+/// from the controller writing each command to this driver waking and writing the resulting state.
+/// Usage: shc_shared_memory_stub_driver [segment_name]
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+  std::string name = (argc > 1 ? argv[1] : SHARED_MEMORY_NAME);
+  signal(SIGINT, [](int) { running = 0; });
+  signal(SIGTERM, [](int) { running = 0; });
+
+  while (running)
+  {
+    printf("Waiting for shared memory segment %s . . .\n", name.c_str());
+    SharedMemoryLayout* layout = openSegment(name);
+    if (!layout)
+    {
+      break;
+    }
+    printf("Connected to shared memory segment %s with %u joints.\n", name.c_str(), layout->joint_count_);
+
+    JointStateData command;
+    std::vector<int64_t> latencies;
+    int64_t last_report = getMonotonicTime();
+    uint32_t sequence = layout->command_.sequence_.load(std::memory_order_acquire);
+    timespec timeout = {COMMAND_TIMEOUT_SECONDS, 0};
+    while (running && layout->version_.load(std::memory_order_acquire) == SHARED_MEMORY_VERSION)
+    {
+      waitForBlockWrite(&layout->command_, sequence, &timeout);
+      uint32_t command_sequence;
+      if (!readBlock(&layout->command_, &command, &command_sequence) || command_sequence == sequence)
+      {
+        continue;
+      }
+      sequence = command_sequence;
+
+      beginBlockWrite(&layout->state_);
+      layout->state_.data_ = command;
+      layout->state_.data_.stamp_ = getMonotonicTime();
+      endBlockWrite(&layout->state_);
+      latencies.push_back(layout->state_.data_.stamp_ - command.stamp_);
+
+      // Report command to state latency percentiles
+      if (layout->state_.data_.stamp_ - last_report > REPORT_PERIOD)
+      {
+        std::sort(latencies.begin(), latencies.end());
+        printf("Commands: %zu, latency (us) p50: %.1f, p99: %.1f, max: %.1f\n", latencies.size(),
+               latencies[latencies.size() / 2] / 1.0e3, latencies[(latencies.size() * 99) / 100] / 1.0e3,
+               latencies.back() / 1.0e3);
+        latencies.clear();
+        last_report = layout->state_.data_.stamp_;
+      }
+    }
+
+    printf("Shared memory segment %s closed.\n", name.c_str());
+    munmap(layout, sizeof(SharedMemoryLayout));
+  }
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
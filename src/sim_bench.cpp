@@ -0,0 +1,221 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syropod_highlevel_controller/control_loop.h"
+#include "syropod_highlevel_controller/yaml_parameters.h"
+
+#include <ros/package.h>
+
+#include <algorithm>
+
+#define DEFAULT_CYCLE_COUNT 10000     ///< Default number of simulated running state cycles
+#define MAX_TRANSITION_CYCLES 100000  ///< Max cycles allowed for the robot to transition to the running state
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Segment of the scripted body velocity input, applied for a fraction of the total simulated cycles.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct VelocitySegment
+{
+  double duration_ratio; ///< Fraction of the total simulated cycles over which this segment is applied
+  double linear_x;       ///< Normalised linear body velocity input along the x axis
+  double linear_y;       ///< Normalised linear body velocity input along the y axis
+  double angular_z;      ///< Normalised angular body velocity input about the z axis
+};
+
+/// Scripted body velocity input: forward walk, forward arc, strafe and finally stop.
+const VelocitySegment VELOCITY_SCRIPT[] = {{0.3, 1.0, 0.0, 0.0},
+                                           {0.3, 0.5, 0.5, 0.5},
+                                           {0.2, 0.0, -1.0, 0.0},
+                                           {0.2, 0.0, 0.0, 0.0}};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Sets the current state of every joint to the desired state, simulating perfect joint tracking by hardware.
+/// @param[in] model A pointer to the robot model
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void applyJointFeedback(std::shared_ptr<Model> model)
+{
+  for (LegContainer::iterator leg_it = model->getLegContainer()->begin();
+       leg_it != model->getLegContainer()->end(); ++leg_it)
+  {
+    std::shared_ptr<Leg> leg = leg_it->second;
+    for (JointContainer::iterator joint_it = leg->getJointContainer()->begin();
+         joint_it != leg->getJointContainer()->end(); ++joint_it)
+    {
+      std::shared_ptr<Joint> joint = joint_it->second;
+      joint->current_position_ = joint->desired_position_;
+      joint->current_velocity_ = joint->desired_velocity_;
+      joint->current_effort_ = joint->desired_effort_;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Prints percentiles of a set of timing samples.
+/// @param[in] label The label of the timed stage
+/// @param[in] samples The timing samples (seconds)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void printPercentiles(const std::string &label, std::vector<double> samples)
+{
+  if (samples.empty())
+  {
+    return;
+  }
+  std::sort(samples.begin(), samples.end());
+  std::size_t last = samples.size() - 1;
+  printf("  %-12s p50: %9.2f  p90: %9.2f  p99: %9.2f  max: %9.2f (us)\n", label.c_str(),
+         1.0e6 * samples[last / 2], 1.0e6 * samples[last * 9 / 10], 1.0e6 * samples[last * 99 / 100],
+         1.0e6 * samples[last]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Headless simulation benchmark. Loads parameters directly from config files and runs the state controller without a
+/// ros master for a number of cycles of scripted body velocity input, with perfect joint feedback. Reports timing
+/// percentiles of each running state update stage, inverse kinematics deviation counts and the final odometry.
+/// Usage: shc_sim_bench [cycle_count] [config_file ...]
+/// Config files default to default.yaml, gait.yaml and auto_pose.yaml of the package config directory.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+  ros::Time::init();
+  ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Error);
+  ros::console::notifyLoggerLevelsChanged();
+
+  int cycle_count = (argc > 1 ? atoi(argv[1]) : DEFAULT_CYCLE_COUNT);
+  std::vector<std::string> config_files(argv + std::min(argc, 2), argv + argc);
+  if (config_files.empty())
+  {
+    // Package is located via ROS_PACKAGE_PATH, so the config directory of installed packages is found
+    std::string package_path = ros::package::getPath("syropod_highlevel_controller");
+    if (package_path.empty())
+    {
+      fprintf(stderr, "Unable to locate syropod_highlevel_controller package, pass config files explicitly\n");
+      return 1;
+    }
+    config_files = {package_path + "/config/default.yaml",
+                    package_path + "/config/gait.yaml",
+                    package_path + "/config/auto_pose.yaml"};
+  }
+
+  // Load config files into local parameter store
+  if (!loadConfigFiles(config_files))
+  {
+    return 1;
+  }
+  getLocalParameters()["/syropod/parameters/debug_rviz"] = false;
+  getLocalParameters()["/syropod/parameters/debug_loop_timing"] = true;
+
+  StateController state;
+  state.init();
+  state.initModel(true);
+  if (state.hasFatalError())
+  {
+    fprintf(stderr, "Controller failed to initialise\n");
+    return 1;
+  }
+  std::shared_ptr<Model> model = state.getModel();
+  configureControlThread(state.getParameters());
+  model->initWorkerPool();
+
+  std_msgs::Int8 system_state;
+  system_state.data = OPERATIONAL;
+  state.systemStateCallback(system_state);
+
+  // Transition robot to running state, as if start button were held
+  std_msgs::Int8 robot_state;
+  robot_state.data = RUNNING;
+  int transition_cycles = 0;
+  while (state.getRobotState() != RUNNING && transition_cycles++ < MAX_TRANSITION_CYCLES)
+  {
+    state.robotStateCallback(robot_state);
+    state.loop();
+    applyJointFeedback(model);
+  }
+  if (state.getRobotState() != RUNNING)
+  {
+    fprintf(stderr, "Robot failed to transition to RUNNING state within %d cycles\n", MAX_TRANSITION_CYCLES);
+    return 1;
+  }
+
+  // IK deviations during transition to running state are excluded from report
+  std::map<int, int> initial_ik_deviation_counts;
+  for (LegContainer::iterator leg_it = model->getLegContainer()->begin();
+       leg_it != model->getLegContainer()->end(); ++leg_it)
+  {
+    initial_ik_deviation_counts[leg_it->first] = leg_it->second->getIKDeviationCount();
+  }
+
+  // Run scripted velocity input
+  std::vector<std::vector<double>> stage_samples(UPDATE_STAGE_COUNT);
+  std::vector<double> loop_samples;
+  loop_samples.reserve(cycle_count);
+  for (std::vector<double> &samples : stage_samples)
+  {
+    samples.reserve(cycle_count);
+  }
+  int segment = 0;
+  int segment_end = 0;
+  int segment_count = sizeof(VELOCITY_SCRIPT) / sizeof(VelocitySegment);
+  geometry_msgs::Twist velocity;
+  for (int cycle = 0; cycle < cycle_count; ++cycle)
+  {
+    while (cycle >= segment_end && segment < segment_count)
+    {
+      velocity.linear.x = VELOCITY_SCRIPT[segment].linear_x;
+      velocity.linear.y = VELOCITY_SCRIPT[segment].linear_y;
+      velocity.angular.z = VELOCITY_SCRIPT[segment].angular_z;
+      segment_end += roundToInt(VELOCITY_SCRIPT[segment].duration_ratio * cycle_count);
+      segment++;
+    }
+    state.bodyVelocityInputCallback(velocity);
+
+    std::chrono::steady_clock::time_point loop_start = std::chrono::steady_clock::now();
+    state.loop();
+    loop_samples.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - loop_start).count());
+
+    std::array<double, UPDATE_STAGE_COUNT> stage_durations = state.getStageDurations();
+    for (int i = 0; i < UPDATE_STAGE_COUNT; ++i)
+    {
+      stage_samples[i].push_back(stage_durations[i]);
+    }
+    applyJointFeedback(model);
+  }
+
+  // Report
+  printf("\nSimulated %d cycles (%.1f s) after %d transition cycles\n",
+         cycle_count, cycle_count * state.getParameters().time_delta.data, transition_cycles);
+  printf("\nTiming:\n");
+  printPercentiles("current pose", stage_samples[CURRENT_POSE_STAGE]);
+  printPercentiles("walk", stage_samples[WALK_STAGE]);
+  printPercentiles("pose", stage_samples[POSE_STAGE]);
+  printPercentiles("model", stage_samples[MODEL_STAGE]);
+  printPercentiles("loop", loop_samples);
+
+  printf("\nIK deviations:\n");
+  int total_ik_deviation_count = 0;
+  for (LegContainer::iterator leg_it = model->getLegContainer()->begin();
+       leg_it != model->getLegContainer()->end(); ++leg_it)
+  {
+    std::shared_ptr<Leg> leg = leg_it->second;
+    int ik_deviation_count = leg->getIKDeviationCount() - initial_ik_deviation_counts[leg_it->first];
+    printf("  %-8s %d\n", leg->getIDName().c_str(), ik_deviation_count);
+    total_ik_deviation_count += ik_deviation_count;
+  }
+  printf("  %-8s %d\n", "total", total_ik_deviation_count);
+
+  Pose odometry = state.getWalker()->getOdometryIdeal();
+  Eigen::Matrix3d covariance = state.getWalker()->getOdometryCovariance();
+  Eigen::Vector3d euler = quaternionToEulerAngles(odometry.rotation_);
+  printf("\nFinal odometry:\n");
+  printf("  position: %.6f %.6f %.6f (m)\n", odometry.position_[0], odometry.position_[1], odometry.position_[2]);
+  printf("  yaw:      %.6f (rad)\n", euler[2]);
+  printf("  variance: %.3e %.3e %.3e (m^2, m^2, rad^2)\n\n", covariance(0, 0), covariance(1, 1), covariance(2, 2));
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
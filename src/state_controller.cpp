@@ -11,89 +11,132 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 StateController::StateController(void)
+  : StateController(ros::isInitialized() ? std::make_shared<ros::NodeHandle>() : NULL,
+                    ros::isInitialized() ? std::make_shared<ros::NodeHandle>("~") : NULL)
 {
-  ros::NodeHandle n;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StateController::StateController(const ros::NodeHandle &node_handle, const ros::NodeHandle &private_node_handle)
+  : StateController(std::make_shared<ros::NodeHandle>(node_handle),
+                    std::make_shared<ros::NodeHandle>(private_node_handle))
+{
+}
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StateController::StateController(std::shared_ptr<ros::NodeHandle> node_handle,
+                                 std::shared_ptr<ros::NodeHandle> private_node_handle)
+  : node_handle_(node_handle)
+  , private_node_handle_(private_node_handle)
+  , debug_visualiser_(node_handle)
+{
   // Get parameters from parameter server and initialises parameter map
   initParameters();
+  loop_profiler_ = std::make_shared<LoopProfiler>(params_.debug_loop_timing.data, params_.time_delta.data);
 
   // Create robot model
   std::shared_ptr<DebugVisualiser> debug_visualiser_ptr =
       std::allocate_shared<DebugVisualiser>(Eigen::aligned_allocator<DebugVisualiser>(), debug_visualiser_);
   model_ = std::allocate_shared<Model>(Eigen::aligned_allocator<Model>(), params_, debug_visualiser_ptr);
   model_->generate();
+  posted_targets_.resize(model_->getLegCount());
+  posted_defaults_.resize(model_->getLegCount());
 
   debug_visualiser_.setTimeDelta(params_.time_delta.data);
+
+  // Running headless (without a ros master) so skip setup of all ros communication
+  if (!node_handle_)
+  {
+    return;
+  }
+
+  ros::NodeHandle &n = *node_handle_;
   transform_listener_ =
       std::allocate_shared<tf2_ros::TransformListener>(Eigen::aligned_allocator<tf2_ros::TransformListener>(),
                                                        transform_buffer_);
 
   // Hexapod Remote topic subscriptions
-  system_state_subscriber_ = n.subscribe("syropod_remote/system_state", 1,
-                                         &StateController::systemStateCallback, this);
-  robot_state_subscriber_ = n.subscribe("syropod_remote/robot_state", 1,
-                                        &StateController::robotStateCallback, this);
-  desired_velocity_subscriber_ = n.subscribe("syropod_remote/desired_velocity", 1,
-                                             &StateController::bodyVelocityInputCallback, this);
-  desired_pose_subscriber_ = n.subscribe("syropod_remote/desired_pose", 1,
-                                         &StateController::bodyPoseInputCallback, this);
-  posing_mode_subscriber_ = n.subscribe("syropod_remote/posing_mode", 1,
-                                        &StateController::posingModeCallback, this);
-  pose_reset_mode_subscriber_ = n.subscribe("syropod_remote/pose_reset_mode", 1,
-                                            &StateController::poseResetCallback, this);
-  gait_selection_subscriber_ = n.subscribe("syropod_remote/gait_selection", 1,
-                                           &StateController::gaitSelectionCallback, this);
-  cruise_control_mode_subscriber_ = n.subscribe("syropod_remote/cruise_control_mode", 1,
-                                                &StateController::cruiseControlCallback, this);
-  planner_mode_subscriber_ = n.subscribe("syropod_remote/planner_mode", 1,
-                                         &StateController::plannerModeCallback, this);
-  primary_leg_selection_subscriber_ = n.subscribe("syropod_remote/primary_leg_selection", 1,
-                                                  &StateController::primaryLegSelectionCallback, this);
-  primary_leg_state_subscriber_ = n.subscribe("syropod_remote/primary_leg_state", 1,
-                                              &StateController::primaryLegStateCallback, this);
-  primary_tip_velocity_subscriber_ = n.subscribe("syropod_remote/primary_tip_velocity", 1,
-                                                 &StateController::primaryTipVelocityInputCallback, this);
-  secondary_leg_selection_subscriber_ = n.subscribe("syropod_remote/secondary_leg_selection", 1,
-                                                    &StateController::secondaryLegSelectionCallback, this);
-  secondary_leg_state_subscriber_ = n.subscribe("syropod_remote/secondary_leg_state", 1,
-                                                &StateController::secondaryLegStateCallback, this);
-  secondary_tip_velocity_subscriber_ = n.subscribe("syropod_remote/secondary_tip_velocity", 1,
-                                                   &StateController::secondaryTipVelocityInputCallback, this);
-  parameter_selection_subscriber_ = n.subscribe("syropod_remote/parameter_selection", 1,
-                                                &StateController::parameterSelectionCallback, this);
-  parameter_adjustment_subscriber_ = n.subscribe("syropod_remote/parameter_adjustment", 1,
-                                                 &StateController::parameterAdjustCallback, this);
+  system_state_subscriber_ = subscribeBuffered(n, "syropod_remote/system_state", 1,
+                                               &StateController::systemStateCallback);
+  robot_state_subscriber_ = subscribeBuffered(n, "syropod_remote/robot_state", 1, &StateController::robotStateCallback);
+  desired_velocity_subscriber_ = subscribeBuffered(n, "syropod_remote/desired_velocity", 1,
+                                                   &StateController::bodyVelocityInputCallback);
+  desired_pose_subscriber_ = subscribeBuffered(n, "syropod_remote/desired_pose", 1,
+                                               &StateController::bodyPoseInputCallback);
+  posing_mode_subscriber_ = subscribeBuffered(n, "syropod_remote/posing_mode", 1, &StateController::posingModeCallback);
+  pose_reset_mode_subscriber_ = subscribeBuffered(n, "syropod_remote/pose_reset_mode", 1,
+                                                  &StateController::poseResetCallback);
+  gait_selection_subscriber_ = subscribeBuffered(n, "syropod_remote/gait_selection", 1,
+                                                 &StateController::gaitSelectionCallback);
+  cruise_control_mode_subscriber_ = subscribeBuffered(n, "syropod_remote/cruise_control_mode", 1,
+                                                      &StateController::cruiseControlCallback);
+  planner_mode_subscriber_ = subscribeBuffered(n, "syropod_remote/planner_mode", 1,
+                                               &StateController::plannerModeCallback);
+  primary_leg_selection_subscriber_ = subscribeBuffered(n, "syropod_remote/primary_leg_selection", 1,
+                                                        &StateController::primaryLegSelectionCallback);
+  primary_leg_state_subscriber_ = subscribeBuffered(n, "syropod_remote/primary_leg_state", 1,
+                                                    &StateController::primaryLegStateCallback);
+  primary_tip_velocity_subscriber_ = subscribeBuffered(n, "syropod_remote/primary_tip_velocity", 1,
+                                                       &StateController::primaryTipVelocityInputCallback);
+  secondary_leg_selection_subscriber_ = subscribeBuffered(n, "syropod_remote/secondary_leg_selection", 1,
+                                                          &StateController::secondaryLegSelectionCallback);
+  secondary_leg_state_subscriber_ = subscribeBuffered(n, "syropod_remote/secondary_leg_state", 1,
+                                                      &StateController::secondaryLegStateCallback);
+  secondary_tip_velocity_subscriber_ = subscribeBuffered(n, "syropod_remote/secondary_tip_velocity", 1,
+                                                         &StateController::secondaryTipVelocityInputCallback);
+  parameter_selection_subscriber_ = subscribeBuffered(n, "syropod_remote/parameter_selection", 1,
+                                                      &StateController::parameterSelectionCallback);
+  parameter_adjustment_subscriber_ = subscribeBuffered(n, "syropod_remote/parameter_adjustment", 1,
+                                                       &StateController::parameterAdjustCallback);
 
   // Hexapod Leg Manipulation topic subscriptions
-  primary_tip_pose_subscriber_ = n.subscribe("/syropod_manipulation/primary_tip_pose", 1,
-                                             &StateController::primaryTipPoseInputCallback, this);
-  secondary_tip_pose_subscriber_ = n.subscribe("/syropod_manipulation/secondary_tip_pose", 1,
-                                               &StateController::secondaryTipPoseInputCallback, this);
+  primary_tip_pose_subscriber_ = subscribeBuffered(n, "/syropod_manipulation/primary_tip_pose", 1,
+                                                   &StateController::primaryTipPoseInputCallback);
+  secondary_tip_pose_subscriber_ = subscribeBuffered(n, "/syropod_manipulation/secondary_tip_pose", 1,
+                                                     &StateController::secondaryTipPoseInputCallback);
 
   // Planner subscription/publisher
-  target_configuration_subscriber_ = n.subscribe("/target_configuration", 1,
-                                                 &StateController::targetConfigurationCallback, this);
-  target_body_pose_subscriber_ = n.subscribe("/target_body_pose", 1,
-                                             &StateController::targetBodyPoseCallback, this);
-  target_tip_pose_subscriber_ = n.subscribe("/target_tip_poses", 100,
-                                            &StateController::targetTipPoseCallback, this);
+  target_configuration_subscriber_ = subscribeBuffered(n, "/target_configuration", 1,
+                                                       &StateController::targetConfigurationCallback);
+  target_body_pose_subscriber_ = subscribeBuffered(n, "/target_body_pose", 1, &StateController::targetBodyPoseCallback);
+  target_tip_pose_subscriber_ = subscribeBuffered(n, "/target_tip_poses", 100, &StateController::targetTipPoseCallback);
   plan_step_request_publisher_ = n.advertise<std_msgs::Int8>("/shc/plan_step_request", 1000);
 
   // Motor and other sensor topic subscriptions
-  imu_data_subscriber_ = n.subscribe(params_.syropod_type.data + "/imu/data", 1, &StateController::imuCallback, this);
-  joint_state_subscriber_ = n.subscribe("/joint_states", 100, &StateController::jointStatesCallback, this);
-  tip_state_subscriber_ = n.subscribe("/tip_states", 1, &StateController::tipStatesCallback, this);
-
-  // Set up debugging publishers
-  velocity_publisher_ = n.advertise<geometry_msgs::Twist>("/shc/velocity", 1000);
-  pose_publisher_ = n.advertise<geometry_msgs::Twist>("/shc/pose", 1000);
-  walkspace_publisher_ = n.advertise<std_msgs::Float32MultiArray>("/shc/walkspace", 1000);
-  rotation_pose_error_publisher_ = n.advertise<std_msgs::Float32MultiArray>("/shc/rotation_pose_error", 1000);
+  imu_data_subscriber_ = subscribeBuffered(n, params_.syropod_type.data + "/imu/data", 1,
+                                           &StateController::imuCallback);
+  joint_state_subscriber_ = subscribeBuffered(n, "/joint_states", 100, &StateController::jointStatesCallback);
+  tip_state_subscriber_ = subscribeBuffered(n, "/tip_states", 1, &StateController::tipStatesCallback);
 
-  // Set up combined desired joint state publisher
+  // Set up combined desired joint state publisher and preallocate messages with fixed joint names and size
   if (params_.combined_control_interface.data)
   {
     desired_joint_state_publisher_ = n.advertise<sensor_msgs::JointState>("/desired_joint_states", 1);
+    sensor_msgs::JointState joint_state_msg;
+    for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+    {
+      leg_it_->second->initDesiredJointStateMsg(&joint_state_msg);
+    }
+
+    // Intra-process subscribers share (and may retain) published messages, hence several are cycled
+    int pool_size = params_.intra_process_control_interface.data ? JOINT_STATE_MSG_POOL_SIZE : 1;
+    for (int i = 0; i < pool_size; ++i)
+    {
+      desired_joint_state_msgs_.push_back(boost::shared_ptr<sensor_msgs::JointState>(
+        new sensor_msgs::JointState(joint_state_msg)));
+    }
+  }
+
+  // Set up shared memory hardware interface, for hardware drivers running on the same machine
+  if (params_.shared_memory_control_interface.data)
+  {
+    shared_memory_interface_ = std::make_shared<SharedMemoryInterface>(model_);
+    if (!shared_memory_interface_->isOpen())
+    {
+      shared_memory_interface_.reset();
+    }
   }
 
   // Set up individual leg state and desired joint state publishers within leg objects
@@ -114,6 +157,9 @@ StateController::StateController(void)
       }
     }
   }
+
+  // Set up debugging publishers on telemetry publisher thread, started after leg state publishers exist
+  telemetry_ = std::make_shared<TelemetryPublisher>(n, model_, params_, transform_buffer_, loop_profiler_);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -159,18 +205,42 @@ void StateController::init(void)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void StateController::processInputs(void)
+{
+  for (std::shared_ptr<InputBuffer> &input_buffer : input_buffers_)
+  {
+    input_buffer->process();
+  }
+  control_callback_queue_.callAvailable();
+
+  if (shared_memory_interface_ && shared_memory_interface_->readState())
+  {
+    checkJointPositionsInitialised();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void StateController::loop(void)
 {
+  loop_profiler_->clearLatestDurations();
+
   // Posing - updates currentPose for body compensation
   if (robot_state_ != UNKNOWN)
   {
-    poser_->updateCurrentPose(robot_state_);
+    {
+      ScopedStageTimer timer(*loop_profiler_, CURRENT_POSE_STAGE);
+      poser_->updateCurrentPose(robot_state_);
+    }
     walker_->setPoseState(poser_->getAutoPoseState()); // Sends pose state from poser to walker
+    collectExternalTargets();
     generateExternalTargetTransforms();
 
     // Admittance control - updates deltaZ values
     if (params_.admittance_control.data)
     {
+      ScopedStageTimer timer(*loop_profiler_, ADMITTANCE_STAGE);
+
       // Calculate new stiffness based on walking cycle
       if (walker_->getWalkState() != STOPPED && params_.dynamic_stiffness.data)
       {
@@ -320,6 +390,10 @@ void StateController::transitionRobotState(void)
       model_->updateDefaultConfiguration();
       model_->generateWorkspaces();
       walker_->generateWalkspace();
+      if (params_.auto_gait_selection.data)
+      {
+        generateGaitLimits();
+      }
       robot_state_ = RUNNING;
       ROS_INFO("\nState transition complete. Syropod is in RUNNING state. Ready to walk.\n");
     }
@@ -364,7 +438,7 @@ void StateController::transitionRobotState(void)
   else
   {
     ROS_FATAL("\nUndefined system state transition was requested! Shutting down controller!\n");
-    ros::shutdown();
+    fatal_error_ = true;
   }
 
   // Transition complete
@@ -412,6 +486,12 @@ void StateController::runningState(void)
     angular_velocity_input_ = angular_cruise_velocity_;
   }
   
+  // Automatically select gait and step frequency for commanded velocity
+  if (params_.auto_gait_selection.data && !gait_change_flag_)
+  {
+    selectGait();
+  }
+
   // Dynamically adjust parameters and change stance if required
   if (parameter_adjust_flag_)
   {
@@ -425,24 +505,42 @@ void StateController::runningState(void)
   // leg state transition (which all only occur once the Syropod has stopped walking)
   if (update_tip_position)
   {
-    // Update tip positions for walking legs
-    walker_->updateWalk(linear_velocity_input_, angular_velocity_input_);
+    {
+      ScopedStageTimer timer(*loop_profiler_, WALK_STAGE);
 
-    // Update tip positions for manually controlled legs
-    walker_->updateManual(primary_leg_selection_, primary_tip_velocity_input_,
-                          secondary_leg_selection_, secondary_tip_velocity_input_);
+      // Update tip positions for walking legs
+      walker_->updateWalk(linear_velocity_input_, angular_velocity_input_);
 
-    // Controls tip position for manually controlled legs.
-    // Primary leg correspond to the front right leg and secondary leg is the front left leg.
-    // TODO: give access for the remaindering legs this feature if selected.
-    walker_->updateManual(primary_leg_selection_, primary_pose_input_,
-                          secondary_leg_selection_, secondary_pose_input_);
+      // Keep auto posing cycle synchronised with step cycle as step frequency is adapted by walk controller
+      StepCycle step = walker_->getStepCycle();
+      if (params_.pose_frequency.data == -1.0 && poser_->getPhaseLength() != step.period_)
+      {
+        poser_->setPhaseLength(step.period_);
+        poser_->setNormaliser(step.period_ / params_.gait_table.base_step_period);
+      }
+
+      // Update tip positions for manually controlled legs
+      walker_->updateManual(primary_leg_selection_, primary_tip_velocity_input_,
+                            secondary_leg_selection_, secondary_tip_velocity_input_);
+
+      // Controls tip position for manually controlled legs.
+      // Primary leg correspond to the front right leg and secondary leg is the front left leg.
+      // TODO: give access for the remaindering legs this feature if selected.
+      walker_->updateManual(primary_leg_selection_, primary_pose_input_,
+                            secondary_leg_selection_, secondary_pose_input_);
+    }
 
     // Pose controller takes current tip positions from walker and applies body posing
-    poser_->updateStance();
-    
+    {
+      ScopedStageTimer timer(*loop_profiler_, POSE_STAGE);
+      poser_->updateStance();
+    }
+
     // Model takes desired tip poses from pose controller and applies inverse/forwards kinematics
-    model_->updateModel();
+    {
+      ScopedStageTimer timer(*loop_profiler_, MODEL_STAGE);
+      model_->updateModel();
+    }
   }
 }
 
@@ -453,7 +551,7 @@ void StateController::adjustParameter(void)
   AdjustableParameter* p = dynamic_parameter_;
   p->current_value = new_parameter_value_;
   bool set_new_parameter = true;
-  if (p->name == "step_frequency")
+  if (p->name == "step_frequency" && params_.step_frequency_mode.data == "fixed")
   {
     // Calculate new speed/acceleration limits due to changing parameter
     StepCycle new_step_cycle = walker_->generateStepCycle(false);
@@ -503,6 +601,7 @@ void StateController::adjustParameter(void)
   if (set_new_parameter)
   {
     parameter_adjust_flag_ = false;
+    updateDynamicConfig();
     ROS_INFO("\n[SHC] Parameter '%s' set to %f. (Default: %f, Min: %f, Max: %f)\n",
                 p->name.c_str(), p->current_value, p->default_value, p->min_value, p->max_value);
   }
@@ -510,13 +609,64 @@ void StateController::adjustParameter(void)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void StateController::updateDynamicConfig(void)
+{
+  // Dynamic reconfigure server is not set up when running headless
+  if (!ros::isInitialized())
+  {
+    return;
+  }
+
+  syropod_highlevel_controller::DynamicConfig config;
+  config.step_frequency = params_.step_frequency.current_value;
+  config.swing_height = params_.swing_height.current_value;
+  config.swing_width = params_.swing_width.current_value;
+  config.step_depth = params_.step_depth.current_value;
+  config.stance_span_modifier = params_.stance_span_modifier.current_value;
+  config.virtual_mass = params_.virtual_mass.current_value;
+  config.virtual_stiffness = params_.virtual_stiffness.current_value;
+  config.virtual_damping_ratio = params_.virtual_damping_ratio.current_value;
+  config.force_gain = params_.force_gain.current_value;
+  dynamic_reconfigure_server_->updateConfig(config);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void StateController::changeGait(void)
 {
-  if (walker_->getWalkState() == STOPPED)
+  WalkState walk_state = walker_->getWalkState();
+  if (walk_state == STOPPED || (walk_state == MOVING && !walker_->isTransitioningGait()))
   {
-    initGaitParameters(gait_selection_);
-    walker_->generateStepCycle();
-    walker_->generateLimits();
+    // Automatic selections may be custom gaits without designation so are initialised by name
+    std::string previous_gait_type = params_.gait_type.data;
+    bool gait_initialised;
+    if (!auto_gait_type_.empty())
+    {
+      gait_initialised = initGaitParameters(auto_gait_type_);
+      auto_gait_type_.clear();
+    }
+    else
+    {
+      gait_initialised = initGaitParameters(gait_selection_);
+    }
+
+    // Revert to previous gait if parameters of new gait are unusable
+    if (!gait_initialised)
+    {
+      initGaitParameters(previous_gait_type);
+      gait_change_flag_ = false;
+      return;
+    }
+    if (walk_state == STOPPED)
+    {
+      walker_->generateStepCycle();
+      walker_->generateLimits();
+    }
+    // Blend leg phases toward new gait whilst walking
+    else
+    {
+      walker_->beginGaitTransition();
+    }
 
     // For auto compensation find associated auto posing parameters for new gait
     if (params_.auto_posing.data && params_.auto_pose_type.data == "auto")
@@ -528,12 +678,169 @@ void StateController::changeGait(void)
     gait_change_flag_ = false;
     ROS_INFO("\nNow using %s mode.\n", params_.gait_type.data.c_str());
   }
-  // Force Syropod to stop walking
+  // Wait for walk cycle to start/stop or complete current transition
   else
   {
-    linear_velocity_input_ = Eigen::Vector2d::Zero();
-    angular_velocity_input_ = 0.0;
-    ROS_INFO_THROTTLE(THROTTLE_PERIOD, "\nStopping Syropod to change gait . . .\n");
+    ROS_INFO_THROTTLE(THROTTLE_PERIOD, "\nWaiting for walk cycle to settle before changing gait . . .\n");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StateController::generateGaitLimits(void)
+{
+  // Define step frequency grid
+  bool fixed_step_frequency = (params_.step_frequency_mode.data == "fixed");
+  double min_step_frequency =
+      fixed_step_frequency ? params_.step_frequency.current_value : params_.step_frequency.default_value;
+  double max_step_frequency =
+      fixed_step_frequency ? min_step_frequency : std::max(params_.step_frequency.max_value, min_step_frequency);
+  double step_frequency_increment = abs(params_.step_frequency.adjust_step);
+  int step_frequency_count = 1;
+  if (step_frequency_increment > 0.0)
+  {
+    step_frequency_count += int(floor((max_step_frequency - min_step_frequency) / step_frequency_increment + 1e-6));
+  }
+
+  // Generate limits for each gait (ordered by ascending step frequency) from the step cycle timing of the gait
+  gait_limits_.clear();
+  std::vector<GaitDefinition>::iterator gait_it;
+  for (gait_it = gait_definitions_.begin(); gait_it != gait_definitions_.end(); ++gait_it)
+  {
+    const GaitTable &gait_table = gait_it->gait_table_;
+    double stance_ratio = double(gait_it->stance_phase_) / (gait_it->stance_phase_ + gait_it->swing_phase_);
+    for (int j = 0; j < step_frequency_count; ++j)
+    {
+      GaitLimits gait_limits;
+      gait_limits.gait_type_ = gait_it->gait_type_;
+      gait_limits.gait_ = gait_it->gait_;
+      gait_limits.step_frequency_ = min_step_frequency + j * step_frequency_increment;
+      gait_limits.stance_ratio_ = stance_ratio;
+      StepCycle step = walker_->generateStepCycle(gait_limits.step_frequency_, gait_table);
+      walker_->generateLimits(step, gait_table, &gait_limits.max_linear_speed_, &gait_limits.max_angular_speed_);
+      gait_limits_.push_back(gait_limits);
+    }
+  }
+
+  gait_limits_walkspace_ = walker_->getWalkspace();
+  gait_limits_step_frequency_ = min_step_frequency;
+  auto_gait_candidate_ = -1;
+  auto_gait_candidate_count_ = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StateController::selectGait(void)
+{
+  // Regenerate limit tables if walkspace (e.g. due to stance adjustment) or step frequency grid has changed
+  bool fixed_step_frequency = (params_.step_frequency_mode.data == "fixed");
+  double min_step_frequency =
+      fixed_step_frequency ? params_.step_frequency.current_value : params_.step_frequency.default_value;
+  if (walker_->getWalkspace() != gait_limits_walkspace_ || min_step_frequency != gait_limits_step_frequency_)
+  {
+    generateGaitLimits();
+  }
+
+  // Only reselect whilst commanded to walk and walk cycle is settled
+  bool has_velocity_command = linear_velocity_input_.norm() || angular_velocity_input_;
+  WalkState walk_state = walker_->getWalkState();
+  if (!has_velocity_command || (walk_state != STOPPED && walk_state != MOVING) || walker_->isTransitioningGait() ||
+      gait_limits_.empty())
+  {
+    return;
+  }
+
+  // Convert throttle input to real velocity as a proportion of the max speed achievable by any candidate
+  std::vector<GaitLimits>::iterator it;
+  Eigen::Vector2d linear_velocity = linear_velocity_input_;
+  double angular_velocity = angular_velocity_input_;
+  if (params_.velocity_input_mode.data == "throttle")
+  {
+    double max_linear_speed = 0.0;
+    double max_angular_speed = 0.0;
+    for (it = gait_limits_.begin(); it != gait_limits_.end(); ++it)
+    {
+      max_linear_speed =
+          std::max(max_linear_speed, walker_->getLimit(linear_velocity, angular_velocity, it->max_linear_speed_));
+      max_angular_speed =
+          std::max(max_angular_speed, walker_->getLimit(linear_velocity, angular_velocity, it->max_angular_speed_));
+    }
+    linear_velocity = clamped(linear_velocity_input_, 1.0) * max_linear_speed;
+    angular_velocity = clamped(angular_velocity_input_, -1.0, 1.0) * max_angular_speed;
+  }
+
+  // Select candidate with largest stance ratio within limits, using the lowest step frequency of each gait within
+  // limits and preferring the candidate with lower speed ratio between gaits of equal stance ratio. If no candidate
+  // is within limits select the candidate with the lowest speed ratio.
+  int selection = -1;
+  int fallback = 0;
+  std::vector<double> speed_ratios;
+  std::map<std::string, bool> gait_within_limits;
+  for (it = gait_limits_.begin(); it != gait_limits_.end(); ++it)
+  {
+    int index = speed_ratios.size();
+    double max_linear_speed = walker_->getLimit(linear_velocity, angular_velocity, it->max_linear_speed_);
+    double max_angular_speed = walker_->getLimit(linear_velocity, angular_velocity, it->max_angular_speed_);
+    double speed_ratio = 0.0;
+    speed_ratio += (linear_velocity.norm() != 0.0 ? linear_velocity.norm() / max_linear_speed : 0.0);
+    speed_ratio += (angular_velocity != 0.0 ? abs(angular_velocity) / max_angular_speed : 0.0);
+    speed_ratios.push_back(speed_ratio);
+    fallback = (speed_ratio < speed_ratios[fallback]) ? index : fallback;
+    if (speed_ratio <= AUTO_GAIT_SPEED_RATIO && !gait_within_limits[it->gait_type_])
+    {
+      gait_within_limits[it->gait_type_] = true;
+      if (selection == -1 || it->stance_ratio_ > gait_limits_[selection].stance_ratio_ ||
+          (it->stance_ratio_ == gait_limits_[selection].stance_ratio_ && speed_ratio < speed_ratios[selection]))
+      {
+        selection = index;
+      }
+    }
+  }
+  selection = (selection == -1) ? fallback : selection;
+  if (selection != auto_gait_candidate_)
+  {
+    auto_gait_candidate_ = selection;
+    auto_gait_candidate_count_ = 0;
+  }
+  auto_gait_speed_ratio_ = speed_ratios[selection];
+
+  // Check if selection differs from current gait/step frequency and if current is unable to achieve velocity
+  const GaitLimits &selected = gait_limits_[selection];
+  double step_frequency = params_.step_frequency.current_value;
+  bool new_gait = (selected.gait_type_ != params_.gait_type.data);
+  bool new_step_frequency = (!fixed_step_frequency && selected.step_frequency_ != step_frequency);
+  if (!new_gait && !new_step_frequency)
+  {
+    return;
+  }
+  bool exceeds_limits = false;
+  for (int i = 0; i < int(gait_limits_.size()); ++i)
+  {
+    if (gait_limits_[i].gait_type_ == params_.gait_type.data && gait_limits_[i].step_frequency_ == step_frequency)
+    {
+      exceeds_limits = (speed_ratios[i] > 1.0);
+    }
+  }
+
+  // Apply selection once it has persisted (or immediately if current selection exceeds limits)
+  auto_gait_candidate_count_++;
+  if (exceeds_limits || auto_gait_candidate_count_ * params_.time_delta.data >= AUTO_GAIT_SELECTION_DELAY)
+  {
+    auto_gait_candidate_count_ = 0;
+    if (new_gait)
+    {
+      gait_selection_ = selected.gait_;
+      auto_gait_type_ = selected.gait_type_;
+      gait_change_flag_ = true;
+    }
+    // Applied via parameter adjustment (unless a manual adjustment is in progress) for clamping and reconfigure update
+    if (new_step_frequency && !parameter_adjust_flag_)
+    {
+      dynamic_parameter_ = &params_.step_frequency;
+      new_parameter_value_ = clamped(selected.step_frequency_, dynamic_parameter_->min_value,
+                                     dynamic_parameter_->max_value);
+      parameter_adjust_flag_ = true;
+    }
   }
 }
 
@@ -570,7 +877,7 @@ void StateController::legStateToggle(void)
         ROS_INFO_COND(leg->getLegState() == WALKING,
                       "\n%s leg transitioning to MANUAL state . . .\n",
                       leg->getIDName().c_str());
-        leg->setLegState(WALKING_TO_MANUAL);
+        walker_->setLegState(leg, WALKING_TO_MANUAL);
         std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
         leg_stepper->setSwingProgress(-1.0);
         leg_stepper->setStanceProgress(-1.0);
@@ -588,7 +895,7 @@ void StateController::legStateToggle(void)
       ROS_INFO_COND(leg->getLegState() == MANUAL,
                     "\n%s leg transitioning to WALKING state . . .\n",
                     leg->getIDName().c_str());
-      leg->setLegState(MANUAL_TO_WALKING);
+      walker_->setLegState(leg, MANUAL_TO_WALKING);
     }
     // WALKING_TO_MANUAL -> MANUAL
     else if (leg->getLegState() == WALKING_TO_MANUAL)
@@ -605,7 +912,7 @@ void StateController::legStateToggle(void)
 
       if (progress == PROGRESS_COMPLETE)
       {
-        leg->setLegState(MANUAL);
+        walker_->setLegState(leg, MANUAL);
         *new_leg_state = MANUAL;
         ROS_INFO("\n%s leg set to state: MANUAL.\n", leg->getIDName().c_str());
         toggle_primary_leg_state_ = false;
@@ -629,7 +936,7 @@ void StateController::legStateToggle(void)
 
       if (progress == PROGRESS_COMPLETE)
       {
-        leg->setLegState(WALKING);
+        walker_->setLegState(leg, WALKING);
         *new_leg_state = WALKING;
         ROS_INFO("\n%s leg set to state: WALKING.\n", leg->getIDName().c_str());
         toggle_primary_leg_state_ = false;
@@ -700,9 +1007,40 @@ void StateController::executePlan(void)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void StateController::collectExternalTargets(void)
+{
+  for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+  {
+    std::shared_ptr<Leg> leg = leg_it_->second;
+    ExternalTarget &external_target = posted_targets_[leg->getIDNumber()];
+    if (external_target.defined_ && robot_state_ == RUNNING)
+    {
+      if (walker_->getWalkState() != STOPPED)
+      {
+        leg->getLegStepper()->setExternalTarget(external_target);
+      }
+      else
+      {
+        leg->getLegPoser()->setExternalTarget(external_target);
+        target_tip_pose_acquired_ = true;
+      }
+    }
+    external_target.defined_ = false;
+
+    ExternalTarget &external_default = posted_defaults_[leg->getIDNumber()];
+    if (external_default.defined_ && robot_state_ == RUNNING && walker_->getWalkState() != STOPPED)
+    {
+      leg->getLegStepper()->setExternalDefault(external_default);
+    }
+    external_default.defined_ = false;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void StateController::generateExternalTargetTransforms(void)
 {
-  // Lookup transform between current walk plane frame and walk plane frame at time of tip target request
+  // Generate transform between current walk plane frame and walk plane frame at time of tip target request
   for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
   {
     std::shared_ptr<Leg> leg = leg_it_->second;
@@ -712,78 +1050,126 @@ void StateController::generateExternalTargetTransforms(void)
     
     // External target transform
     external_target = leg_stepper->getExternalTarget();
-    if (external_target.defined_)
+    if (external_target.defined_ && !external_target.planned_)
     {
-      ros::Time past = external_target.time_;
-      std::string frame_id = external_target.frame_id_;
-      try
+      if (generateExternalTargetTransform(&external_target, false))
       {
-        geometry_msgs::TransformStamped target_transform;
-        target_transform = 
-          transform_buffer_.lookupTransform(frame_id, past, "walk_plane", ros::Time(0), fixed_frame_id_);
-        external_target.transform_ = Pose(target_transform.transform);
         leg_stepper->setExternalTarget(external_target);
       }
-      catch (tf2::TransformException &ex) 
-      {
-        ROS_DEBUG("\n[SHC] Unable to look up external target transform -- (%s)\n",ex.what());
-      }
     }
     
     // External default transform
     external_target = leg_stepper->getExternalDefault();
     if (external_target.defined_)
     {
-      ros::Time past = external_target.time_;
-      std::string frame_id = external_target.frame_id_;
-      try
+      if (generateExternalTargetTransform(&external_target, false))
       {
-        geometry_msgs::TransformStamped default_transform;
-        default_transform = 
-          transform_buffer_.lookupTransform(frame_id, past, "walk_plane", ros::Time(0), fixed_frame_id_);
-        external_target.transform_ = Pose(default_transform.transform);
         leg_stepper->setExternalDefault(external_target);
       }
-      catch (tf2::TransformException &ex) 
-      {
-        ROS_DEBUG("\n[SHC] Unable to look up external default transform -- (%s)\n",ex.what());
-      }
     }
     
     // External target transform for planner mode
     external_target = leg_poser->getExternalTarget();
     if (external_target.defined_)
     {
-      ros::Time past = external_target.time_;
-      std::string frame_id = external_target.frame_id_;
-      try
+      if (generateExternalTargetTransform(&external_target, true))
       {
-        geometry_msgs::TransformStamped target_transform;
-        target_transform = 
-          transform_buffer_.lookupTransform("base_link", ros::Time(0), frame_id, past, fixed_frame_id_);
-        external_target.transform_ = Pose(target_transform.transform);
         leg_poser->setExternalTarget(external_target);
       }
-      catch (tf2::TransformException &ex) 
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool StateController::generateExternalTargetTransform(ExternalTarget *external_target, const bool &to_base_link)
+{
+  ros::Time past = external_target->time_;
+  const std::string &frame_id = getFrameName(external_target->frame_id_);
+  try
+  {
+    // External odometry is only available via tf
+    if (fixed_frame_id_ != "odom_ideal")
+    {
+      geometry_msgs::TransformStamped target_transform;
+      if (to_base_link)
+      {
+        target_transform =
+          transform_buffer_.lookupTransform("base_link", ros::Time(0), frame_id, past, fixed_frame_id_);
+      }
+      else
+      {
+        target_transform =
+          transform_buffer_.lookupTransform(frame_id, past, "walk_plane", ros::Time(0), fixed_frame_id_);
+      }
+      external_target->transform_ = Pose(target_transform.transform);
+      return true;
+    }
+
+    // Pose of odom_ideal in reference frame is fixed for a given request time, so is only looked up once. Requests
+    // stamped with zero time denote the latest transform, which is looked up every cycle.
+    if (!external_target->request_transform_defined_ || past.isZero())
+    {
+      if (external_target->frame_id_ == ODOM_IDEAL_FRAME_ID)
+      {
+        external_target->request_transform_ = Pose::Identity();
+      }
+      else
       {
-        ROS_DEBUG("\n[SHC] Unable to look up external target transform -- (%s)\n",ex.what());
+        geometry_msgs::TransformStamped request_transform;
+        request_transform = transform_buffer_.lookupTransform(frame_id, "odom_ideal", past);
+        external_target->request_transform_ = Pose(request_transform.transform);
       }
+      external_target->request_transform_defined_ = !past.isZero();
     }
   }
+  catch (tf2::TransformException &ex)
+  {
+    ROS_DEBUG("\n[SHC] Unable to look up external target transform -- (%s)\n", ex.what());
+    return false;
+  }
+
+  // Compose with current ideal odometry (pose of walk plane in odom_ideal)
+  Pose walk_plane_transform = external_target->request_transform_.addPose(walker_->getOdometryIdeal());
+  if (to_base_link)
+  {
+    external_target->transform_ = ~walk_plane_transform.addPose(model_->getCurrentPose());
+  }
+  else
+  {
+    external_target->transform_ = walk_plane_transform;
+  }
+  return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void StateController::publishDesiredJointState(void)
 {
-  sensor_msgs::JointState joint_state_msg;
+  ScopedStageTimer timer(*loop_profiler_, JOINT_STATE_PUBLISH_STAGE);
+
+  // Shared memory commands bypass ros entirely, so are written first to minimise latency
+  if (shared_memory_interface_)
+  {
+    shared_memory_interface_->writeCommand();
+  }
+
+  // Combined messages are preallocated on set up of ros communication, so none exist whilst running headless
+  boost::shared_ptr<sensor_msgs::JointState> joint_state_msg;
+  if (params_.combined_control_interface.data && !desired_joint_state_msgs_.empty())
+  {
+    joint_state_msg = acquireDesiredJointStateMsg();
+    joint_state_msg->header.stamp = ros::Time::now();
+  }
+
+  int joint_index = 0;
   for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
   {
     std::shared_ptr<Leg> leg = leg_it_->second;
     JointContainer::iterator joint_it;
-    if (params_.combined_control_interface.data)
+    if (joint_state_msg)
     {
-      leg->generateDesiredJointStateMsg(&joint_state_msg);
+      joint_index = leg->updateDesiredJointStateMsg(joint_state_msg.get(), joint_index);
     }
     
     if (params_.individual_control_interface.data)
@@ -798,258 +1184,150 @@ void StateController::publishDesiredJointState(void)
     }
   }
 
-  if (params_.combined_control_interface.data)
+  // Publishing by shared pointer passes the message to intra-process subscribers without serialisation
+  if (joint_state_msg && params_.intra_process_control_interface.data)
   {
     desired_joint_state_publisher_.publish(joint_state_msg);
   }
+  else if (joint_state_msg)
+  {
+    desired_joint_state_publisher_.publish(*joint_state_msg);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StateController::publishLegState(void)
+boost::shared_ptr<sensor_msgs::JointState> StateController::acquireDesiredJointStateMsg(void)
 {
-
-  for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+  std::vector<boost::shared_ptr<sensor_msgs::JointState>>::iterator msg_it;
+  for (msg_it = desired_joint_state_msgs_.begin(); msg_it != desired_joint_state_msgs_.end(); ++msg_it)
   {
-    syropod_highlevel_controller::LegState msg;
-    std::shared_ptr<Leg> leg = leg_it_->second;
-    std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
-    std::shared_ptr<LegPoser> leg_poser = leg->getLegPoser();
-    msg.header.stamp = ros::Time::now();
-    msg.name = leg->getIDName().c_str();
-
-    // Tip poses
-    msg.walker_tip_pose.header.stamp = ros::Time::now();
-    msg.walker_tip_pose.header.frame_id = "walk_plane";
-    msg.walker_tip_pose.pose = leg_stepper->getCurrentTipPose().toPoseMessage();
-    
-    msg.target_tip_pose.header.stamp = ros::Time::now();
-    msg.target_tip_pose.header.frame_id = "walk_plane";
-    msg.target_tip_pose.pose = leg_stepper->getTargetTipPose().toPoseMessage();
-    
-    msg.poser_tip_pose.header.stamp = ros::Time::now();
-    msg.poser_tip_pose.header.frame_id = "base_link";
-    msg.poser_tip_pose.pose = leg_poser->getCurrentTipPose().toPoseMessage();
-    
-    msg.model_tip_pose.header.stamp = ros::Time::now();
-    msg.model_tip_pose.header.frame_id = "base_link";
-    msg.model_tip_pose.pose = leg->getCurrentTipPose().toPoseMessage();
-    
-    msg.actual_tip_pose.header.stamp = ros::Time::now();
-    msg.actual_tip_pose.header.frame_id = "base_link";
-    msg.actual_tip_pose.pose = leg->applyFK(false, true).toPoseMessage();
-    leg->applyFK();
-
-    // Tip velocities
-    msg.model_tip_velocity.header.stamp = ros::Time::now();
-    msg.model_tip_pose.header.frame_id = "base_link";
-    msg.model_tip_velocity.twist.linear.x = leg->getCurrentTipVelocity()[0];
-    msg.model_tip_velocity.twist.linear.y = leg->getCurrentTipVelocity()[1];
-    msg.model_tip_velocity.twist.linear.z = leg->getCurrentTipVelocity()[2];
-
-    // Joint positions/velocities
-    for (joint_it_ = leg->getJointContainer()->begin(); joint_it_ != leg->getJointContainer()->end(); ++joint_it_)
+    if (msg_it->use_count() == 1)
     {
-      std::shared_ptr<Joint> joint = joint_it_->second;
-      msg.joint_positions.push_back(joint->desired_position_);
-      msg.joint_velocities.push_back(joint->desired_velocity_);
-      msg.joint_efforts.push_back(joint->desired_effort_);
+      return *msg_it;
     }
-
-    // Step progress
-    msg.swing_progress = leg_stepper->getSwingProgress();
-    msg.stance_progress = leg_stepper->getStanceProgress();
-    StepCycle step = walker_->getStepCycle();
-    double swing_time = (double(step.swing_period_) / step.period_) / step.frequency_;
-    double stance_time = (double(step.stance_period_) / step.period_) / step.frequency_;
-    double time_to_swing_end;
-    if (leg_stepper->getStanceProgress() >= 0.0)
-    {
-      time_to_swing_end = stance_time * (1.0 - leg_stepper->getStanceProgress()) + swing_time;
-    }
-    else
-    {
-      time_to_swing_end = swing_time * (1.0 - leg_stepper->getSwingProgress());
-    }
-    msg.time_to_swing_end = time_to_swing_end;
-    msg.pose_delta = walker_->calculateOdometry(time_to_swing_end).toPoseMessage();
-
-    // Leg specific auto pose
-    Eigen::Vector3d position = leg_poser->getAutoPose().position_;
-    Eigen::Quaterniond rotation = leg_poser->getAutoPose().rotation_;
-    msg.auto_pose = Pose(position, rotation).toPoseMessage();
-
-    // Admittance controller
-    msg.tip_force.x = leg->getTipForceCalculated()[0] * params_.force_gain.current_value;
-    msg.tip_force.y = leg->getTipForceCalculated()[1] * params_.force_gain.current_value;
-    msg.tip_force.z = leg->getTipForceCalculated()[2] * params_.force_gain.current_value;
-    msg.admittance_delta.x = leg->getAdmittanceDelta()[0];
-    msg.admittance_delta.y = leg->getAdmittanceDelta()[1];
-    msg.admittance_delta.z = leg->getAdmittanceDelta()[2];
-    msg.virtual_stiffness = leg->getVirtualStiffness();
-
-    leg->publishState(msg);
   }
-}
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void StateController::publishVelocity(void)
-{
-  geometry_msgs::Twist msg;
-  msg.linear.x = walker_->getDesiredLinearVelocity()[0];
-  msg.linear.y = walker_->getDesiredLinearVelocity()[1];
-  msg.linear.z = 0.0;
-  msg.angular.x = 0.0;
-  msg.angular.y = 0.0;
-  msg.angular.z = walker_->getDesiredAngularVelocity();
-  velocity_publisher_.publish(msg);
+  // Every pooled message is still retained by a subscriber, so replace one with a copy (left to its subscriber)
+  desired_joint_state_msgs_.front().reset(new sensor_msgs::JointState(*desired_joint_state_msgs_.front()));
+  return desired_joint_state_msgs_.front();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StateController::publishPose(void)
+void StateController::publishTelemetry(void)
 {
-  geometry_msgs::Twist msg;
-  Eigen::Vector3d position = model_->getCurrentPose().position_;
-  Eigen::Quaterniond rotation = model_->getCurrentPose().rotation_;
-  msg.linear.x = position[0];
-  msg.linear.y = position[1];
-  msg.linear.z = position[2];
-  msg.angular.x = quaternionToEulerAngles(rotation)[0];
-  msg.angular.y = quaternionToEulerAngles(rotation)[1];
-  msg.angular.z = quaternionToEulerAngles(rotation)[2];
-  pose_publisher_.publish(msg);
-}
+  // Running headless (without a ros master) so no telemetry publisher exists
+  if (!telemetry_)
+  {
+    return;
+  }
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  fixed_frame_id_ = telemetry_->isOdomAvailable() ? "odom" : "odom_ideal";
 
-void StateController::publishWalkspace(void)
-{
-  if (robot_state_ == RUNNING)
+  TelemetrySnapshot* snapshot = telemetry_->beginCapture();
+  if (!snapshot)
   {
-    std_msgs::Float32MultiArray msg;
-    LimitMap walkspace_map = walker_->getWalkspace();
-    LimitMap::iterator walkspace_it;
-    for (walkspace_it = walkspace_map.begin(); walkspace_it != walkspace_map.end(); ++walkspace_it)
-    {
-      msg.data.push_back(static_cast<float>(walkspace_it->second));
-    }
-    
-    walkspace_publisher_.publish(msg);
+    return;
   }
-}
 
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+  snapshot->time_ = ros::Time::now();
+  snapshot->running_ = (robot_state_ == RUNNING);
+  snapshot->desired_linear_velocity_ = walker_->getDesiredLinearVelocity();
+  snapshot->desired_angular_velocity_ = walker_->getDesiredAngularVelocity();
+  snapshot->current_pose_ = model_->getCurrentPose();
+  snapshot->odometry_ideal_ = walker_->getOdometryIdeal();
+  snapshot->odometry_covariance_ = walker_->getOdometryCovariance();
 
-void StateController::publishRotationPoseError(void)
-{
-  std_msgs::Float32MultiArray msg;
-  msg.data.clear();
-  msg.data.push_back(static_cast<float>(poser_->getRotationAbsementError()[0]));
-  msg.data.push_back(static_cast<float>(poser_->getRotationAbsementError()[1]));
-  msg.data.push_back(static_cast<float>(poser_->getRotationAbsementError()[2]));
-  msg.data.push_back(static_cast<float>(poser_->getRotationPositionError()[0]));
-  msg.data.push_back(static_cast<float>(poser_->getRotationPositionError()[1]));
-  msg.data.push_back(static_cast<float>(poser_->getRotationPositionError()[2]));
-  msg.data.push_back(static_cast<float>(poser_->getRotationVelocityError()[0]));
-  msg.data.push_back(static_cast<float>(poser_->getRotationVelocityError()[1]));
-  msg.data.push_back(static_cast<float>(poser_->getRotationVelocityError()[2]));
-  rotation_pose_error_publisher_.publish(msg);
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-void StateController::publishFrameTransforms(void)
-{
-  Pose odom_ideal_to_walk_plane = walker_->getOdometryIdeal();
-  Pose walk_plane_to_base_link = model_->getCurrentPose();
-  Pose odom_ideal_to_base_link = odom_ideal_to_walk_plane.addPose(walk_plane_to_base_link);
-  
-  // Broadcast ideal odom tf, if odom tf from perception does not exist on tf tree
-  try
+  snapshot->walkspace_count_ = 0;
+  const LimitMap &walkspace_map = walker_->getWalkspace();
+  LimitMap::const_iterator walkspace_it;
+  for (walkspace_it = walkspace_map.begin(); walkspace_it != walkspace_map.end(); ++walkspace_it)
   {
-    fixed_frame_id_ = "odom";
-    transform_buffer_.lookupTransform("base_link", "odom", ros::Time(0));
+    if (snapshot->walkspace_count_ < WALKSPACE_BEARING_COUNT)
+    {
+      snapshot->walkspace_[snapshot->walkspace_count_++] = walkspace_it->second;
+    }
   }
-  catch (tf2::TransformException &ex) 
+
+  snapshot->gait_selection_defined_ = params_.auto_gait_selection.data && auto_gait_candidate_ != -1;
+  if (snapshot->gait_selection_defined_)
   {
-    ROS_WARN_ONCE("\n[SHC] No odom transform exists in tf tree - using ideal odometry\n");
-    
-    fixed_frame_id_ = "odom_ideal";
-    geometry_msgs::TransformStamped odom_to_base_link;
-    odom_to_base_link.header.stamp = ros::Time::now();
-    odom_to_base_link.header.frame_id = "odom_ideal";
-    odom_to_base_link.child_frame_id = "base_link";
-    odom_to_base_link.transform.translation.x = odom_ideal_to_base_link.position_[0];
-    odom_to_base_link.transform.translation.y = odom_ideal_to_base_link.position_[1];
-    odom_to_base_link.transform.translation.z = odom_ideal_to_base_link.position_[2];
-    odom_to_base_link.transform.rotation.w = odom_ideal_to_base_link.rotation_.w();
-    odom_to_base_link.transform.rotation.x = odom_ideal_to_base_link.rotation_.x();
-    odom_to_base_link.transform.rotation.y = odom_ideal_to_base_link.rotation_.y();
-    odom_to_base_link.transform.rotation.z = odom_ideal_to_base_link.rotation_.z();
-    transform_broadcaster_.sendTransform(odom_to_base_link);
+    const GaitLimits &selected = gait_limits_[auto_gait_candidate_];
+    snapshot->gait_selection_[0] = selected.gait_;
+    snapshot->gait_selection_[1] = selected.step_frequency_;
+    snapshot->gait_selection_[2] = auto_gait_speed_ratio_;
   }
-  
-  // Base Link frame to Walk Plane frame transform
-  geometry_msgs::TransformStamped base_link_to_walk_plane;
-  base_link_to_walk_plane.header.stamp = ros::Time::now();
-  base_link_to_walk_plane.header.frame_id = "base_link";
-  base_link_to_walk_plane.child_frame_id = "walk_plane";
-  base_link_to_walk_plane.transform.translation.x = (~walk_plane_to_base_link).position_[0];
-  base_link_to_walk_plane.transform.translation.y = (~walk_plane_to_base_link).position_[1];
-  base_link_to_walk_plane.transform.translation.z = (~walk_plane_to_base_link).position_[2];
-  base_link_to_walk_plane.transform.rotation.w = (~walk_plane_to_base_link).rotation_.w();
-  base_link_to_walk_plane.transform.rotation.x = (~walk_plane_to_base_link).rotation_.x();
-  base_link_to_walk_plane.transform.rotation.y = (~walk_plane_to_base_link).rotation_.y();
-  base_link_to_walk_plane.transform.rotation.z = (~walk_plane_to_base_link).rotation_.z();
-  transform_broadcaster_.sendTransform(base_link_to_walk_plane);
-  
-  // Base Link frame to Joint/Tip frames
+
+  snapshot->rotation_absement_error_ = poser_->getRotationAbsementError();
+  snapshot->rotation_position_error_ = poser_->getRotationPositionError();
+  snapshot->rotation_velocity_error_ = poser_->getRotationVelocityError();
+
+  StepCycle step = walker_->getStepCycle();
+  double swing_time = (double(step.swing_period_) / step.period_) / step.frequency_;
+  double stance_time = (double(step.stance_period_) / step.period_) / step.frequency_;
   for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
   {
     std::shared_ptr<Leg> leg = leg_it_->second;
-    for (joint_it_ = leg->getJointContainer()->begin(); joint_it_ != leg->getJointContainer()->end(); ++joint_it_)
+    if (leg->getIDNumber() < 0 || leg->getIDNumber() >= MAX_LEG_COUNT)
+    {
+      continue;
+    }
+    std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
+    std::shared_ptr<LegPoser> leg_poser = leg->getLegPoser();
+    LegTelemetry &leg_telemetry = snapshot->legs_[leg->getIDNumber()];
+
+    // Tip poses/velocities
+    leg_telemetry.walker_tip_pose_ = leg_stepper->getCurrentTipPose();
+    leg_telemetry.target_tip_pose_ = leg_stepper->getTargetTipPose();
+    leg_telemetry.poser_tip_pose_ = leg_poser->getCurrentTipPose();
+    leg_telemetry.model_tip_pose_ = leg->getCurrentTipPose();
+    leg_telemetry.model_tip_velocity_ = leg->getCurrentTipVelocity();
+
+    // Joint positions/velocities
+    int joint_index = 0;
+    for (joint_it_ = leg->getJointContainer()->begin();
+         joint_it_ != leg->getJointContainer()->end() && joint_index < MAX_JOINT_COUNT; ++joint_it_)
     {
       std::shared_ptr<Joint> joint = joint_it_->second;
-      Pose joint_robot_frame = joint->getPoseRobotFrame();
-      geometry_msgs::TransformStamped base_link_to_joint;
-      base_link_to_joint.header.stamp = ros::Time::now();
-      base_link_to_joint.header.frame_id = "base_link";
-      base_link_to_joint.child_frame_id = joint->id_name_;
-      base_link_to_joint.transform.translation.x = joint_robot_frame.position_[0];
-      base_link_to_joint.transform.translation.y = joint_robot_frame.position_[1];
-      base_link_to_joint.transform.translation.z = joint_robot_frame.position_[2];
-      Eigen::Quaterniond rotation = 
-        joint_robot_frame.rotation_ * Eigen::AngleAxisd(joint->desired_position_, Eigen::Vector3d::UnitZ());
-      base_link_to_joint.transform.rotation.w = rotation.w();
-      base_link_to_joint.transform.rotation.x = rotation.x();
-      base_link_to_joint.transform.rotation.y = rotation.y();
-      base_link_to_joint.transform.rotation.z = rotation.z();
-      transform_broadcaster_.sendTransform(base_link_to_joint);
-    }
-
-    geometry_msgs::TransformStamped base_link_to_tip;
-    std::shared_ptr<Tip> tip = leg->getTip();
-    Pose tip_robot_frame = tip->getPoseRobotFrame();
-    base_link_to_tip.header.stamp = ros::Time::now();
-    base_link_to_tip.header.frame_id = "base_link";
-    base_link_to_tip.child_frame_id = tip->id_name_;
-    base_link_to_tip.transform.translation.x = tip_robot_frame.position_[0];
-    base_link_to_tip.transform.translation.y = tip_robot_frame.position_[1];
-    base_link_to_tip.transform.translation.z = tip_robot_frame.position_[2];
-    base_link_to_tip.transform.rotation.w = tip_robot_frame.rotation_.w();
-    base_link_to_tip.transform.rotation.x = tip_robot_frame.rotation_.x();
-    base_link_to_tip.transform.rotation.y = tip_robot_frame.rotation_.y();
-    base_link_to_tip.transform.rotation.z = tip_robot_frame.rotation_.z();
-    transform_broadcaster_.sendTransform(base_link_to_tip);
+      leg_telemetry.desired_positions_[joint_index] = joint->desired_position_;
+      leg_telemetry.desired_velocities_[joint_index] = joint->desired_velocity_;
+      leg_telemetry.desired_efforts_[joint_index] = joint->desired_effort_;
+      leg_telemetry.current_positions_[joint_index] = joint->current_position_;
+      joint_index++;
+    }
+
+    // Step progress
+    leg_telemetry.swing_progress_ = leg_stepper->getSwingProgress();
+    leg_telemetry.stance_progress_ = leg_stepper->getStanceProgress();
+    if (leg_stepper->getStanceProgress() >= 0.0)
+    {
+      leg_telemetry.time_to_swing_end_ = stance_time * (1.0 - leg_stepper->getStanceProgress()) + swing_time;
+    }
+    else
+    {
+      leg_telemetry.time_to_swing_end_ = swing_time * (1.0 - leg_stepper->getSwingProgress());
+    }
+    leg_telemetry.pose_delta_ = walker_->calculateOdometry(leg_telemetry.time_to_swing_end_);
+
+    // Leg specific auto pose
+    leg_telemetry.auto_pose_ = leg_poser->getAutoPose();
+
+    // Admittance controller
+    leg_telemetry.tip_force_ = leg->getTipForceCalculated() * params_.force_gain.current_value;
+    leg_telemetry.admittance_delta_ = leg->getAdmittanceDelta();
+    leg_telemetry.virtual_stiffness_ = leg->getVirtualStiffness();
   }
+
+  telemetry_->endCapture();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void StateController::RVIZDebugging(void)
 {
+  ScopedStageTimer timer(*loop_profiler_, RVIZ_DEBUGGING_STAGE);
+
   debug_visualiser_.generateRobotModel(model_);
   debug_visualiser_.generateGravity(poser_->estimateGravity());
   debug_visualiser_.generateWalkPlane(walker_->getWalkPlane(), walker_->getWalkPlaneNormal());
@@ -1211,6 +1489,7 @@ void StateController::gaitSelectionCallback(const std_msgs::Int8 &input)
     if (new_gait_selection != gait_selection_ && new_gait_selection != GAIT_UNDESIGNATED)
     {
       gait_selection_ = new_gait_selection;
+      auto_gait_type_.clear();
       gait_change_flag_ = true;
     }
   }
@@ -1590,7 +1869,13 @@ void StateController::jointStatesCallback(const sensor_msgs::JointState &joint_s
     }
   }
 
-  // Check if all joint positions have been received from topic
+  checkJointPositionsInitialised();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StateController::checkJointPositionsInitialised(void)
+{
   if (!joint_positions_initialised_)
   {
     joint_positions_initialised_ = true;
@@ -1659,6 +1944,10 @@ void StateController::tipStatesCallback(const syropod_highlevel_controller::TipS
         // Transform into robot frame and store
         Pose step_plane_pose = leg->getTip()->getPoseRobotFrame(Pose(step_plane_position, step_plane_orientation));
         leg->setStepPlanePose(step_plane_pose); 
+        if (params_.rough_terrain_mode.data && walker_ != NULL)
+        {
+          walker_->updateTerrainMap(leg);
+        }
       }
       else
       {
@@ -1700,62 +1989,40 @@ void StateController::targetBodyPoseCallback(const geometry_msgs::Pose &target_b
 
 void StateController::targetTipPoseCallback(const syropod_highlevel_controller::TargetTipPose &msg)
 {
-  if (robot_state_ == RUNNING)
+  // Post targets and defaults per leg in a single pass, to be collected later in the same control cycle
+  for (uint i = 0; i < msg.name.size(); ++i)
   {
-    for (uint i = 0; i < msg.name.size(); ++i)
+    std::shared_ptr<Leg> leg = model_->getLegByIDName(msg.name[i]);
+    if (leg == NULL)
     {
-      std::shared_ptr<Leg> leg = model_->getLegByIDName(msg.name[i]);
-      if (leg != NULL)
-      {
-        std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
-        std::shared_ptr<LegPoser> leg_poser = leg->getLegPoser();
+      ROS_ERROR("\nRequested target tip pose for leg '%s' failed. Leg '%s' does not exist in model.\n",
+                msg.name[i].c_str(), msg.name[i].c_str());
+      return;
+    }
 
-        if (leg->getIDName() == msg.name[i])
-        {
-          bool is_external_target = !msg.target.empty() && Pose(msg.target[i].pose) != Pose::Undefined();
-          bool is_external_default = !msg.stance.empty() && Pose(msg.stance[i].pose) != Pose::Undefined();
-          
-          // Create external target from message and send to walk/pose controller depending on walk state
-          if (is_external_target)
-          {
-            ExternalTarget external_target;
-            external_target.pose_ = Pose(msg.target[i].pose);
-            bool swing_clearance = msg.swing_clearance.size() > 0;
-            external_target.swing_clearance_ = static_cast<double>(swing_clearance ? msg.swing_clearance[i] : 0.0);
-            external_target.time_ = msg.target[i].header.stamp;
-            external_target.frame_id_ = msg.target[i].header.frame_id;
-            external_target.transform_ = Pose::Identity(); // Correctly set from tf tree in main loop
-            external_target.defined_ = true;
-            if (walker_->getWalkState() != STOPPED)
-            {
-              leg_stepper->setExternalTarget(external_target);
-            }
-            else
-            {
-              leg_poser->setExternalTarget(external_target);
-              target_tip_pose_acquired_ = true;
-            }
-          }
-          
-          // Create external default from message and send to walk/ controller if walking
-          if (is_external_default && walker_->getWalkState() != STOPPED)
-          {
-            ExternalTarget external_default;
-            external_default.pose_ = Pose(msg.stance[i].pose);
-            external_default.swing_clearance_ = 0.0;
-            external_default.time_ = msg.stance[i].header.stamp;
-            external_default.frame_id_ = msg.stance[i].header.frame_id;
-            external_default.transform_ = Pose::Identity(); // Correctly set from tf tree in main loop
-            external_default.defined_ = true;
-            leg_stepper->setExternalDefault(external_default);
-          }
-        }
+    ExternalTarget external_target;
+    external_target.transform_ = Pose::Identity(); // Correctly set from tf tree in main loop
+    external_target.defined_ = true;
+    if (i < msg.target.size())
+    {
+      external_target.pose_ = Pose(msg.target[i].pose);
+      if (external_target.pose_ != Pose::Undefined())
+      {
+        external_target.swing_clearance_ = (i < msg.swing_clearance.size() ? msg.swing_clearance[i] : 0.0);
+        external_target.time_ = msg.target[i].header.stamp;
+        external_target.frame_id_ = internFrameID(msg.target[i].header.frame_id);
+        posted_targets_[leg->getIDNumber()] = external_target;
       }
-      else
+    }
+    if (i < msg.stance.size())
+    {
+      external_target.pose_ = Pose(msg.stance[i].pose);
+      if (external_target.pose_ != Pose::Undefined())
       {
-        ROS_ERROR("\nRequested target tip pose for leg '%s' failed. Leg '%s' does not exist in model.\n",
-                  msg.name[i].c_str(), msg.name[i].c_str());
-        return;
+        external_target.swing_clearance_ = 0.0;
+        external_target.time_ = msg.stance[i].header.stamp;
+        external_target.frame_id_ = internFrameID(msg.stance[i].header.frame_id);
+        posted_defaults_[leg->getIDNumber()] = external_target;
       }
     }
   }
@@ -1773,10 +2040,22 @@ void StateController::initParameters(void)
   params_.manual_posing.init("manual_posing");
   params_.inclination_posing.init("inclination_posing");
   params_.admittance_control.init("admittance_control");
+  params_.leg_update_threads.initOptional("leg_update_threads", 0);
+  params_.control_thread_priority.initOptional("control_thread_priority", 0);
+  params_.control_thread_core.initOptional("control_thread_core", -1);
+  int core_count = static_cast<int>(std::thread::hardware_concurrency());
+  if (core_count > 0 && params_.control_thread_core.data >= core_count)
+  {
+    ROS_WARN("\nControl thread core %d exceeds available CPU cores (%d), leaving control thread unpinned.\n",
+             params_.control_thread_core.data, core_count);
+    params_.control_thread_core.data = -1;
+  }
 
   // Hardware interface parameters
   params_.individual_control_interface.init("individual_control_interface");
   params_.combined_control_interface.init("combined_control_interface");
+  params_.intra_process_control_interface.initOptional("intra_process_control_interface", false);
+  params_.shared_memory_control_interface.initOptional("shared_memory_control_interface", false);
 
   // Model parameters
   params_.syropod_type.init("syropod_type");
@@ -1797,6 +2076,20 @@ void StateController::initParameters(void)
   params_.step_depth.init("step_depth");
   params_.stance_span_modifier.init("stance_span_modifier");
   params_.velocity_input_mode.init("velocity_input_mode");
+  params_.step_frequency_mode.initOptional("step_frequency_mode", "fixed");
+  if (params_.step_frequency_mode.data != "fixed" && params_.step_frequency_mode.data != "continuous" &&
+      params_.step_frequency_mode.data != "cadence")
+  {
+    ROS_WARN("\nUnknown step_frequency_mode '%s', using 'fixed' step frequency.\n",
+             params_.step_frequency_mode.data.c_str());
+    params_.step_frequency_mode.data = "fixed";
+  }
+  params_.auto_gait_selection.initOptional("auto_gait_selection", false);
+  params_.footstep_planning.initOptional("footstep_planning", false);
+  params_.footstep_planning_horizon.initOptional("footstep_planning_horizon", 3);
+  params_.footstep_planning_resolution.initOptional("footstep_planning_resolution", 0.01);
+  params_.terrain_map_resolution.initOptional("terrain_map_resolution", 0.02);
+  params_.odometry_fusion.initOptional("odometry_fusion", false);
   params_.body_velocity_scaler.init("body_velocity_scaler");
   params_.force_cruise_velocity.init("force_cruise_velocity");
   params_.linear_cruise_velocity.init("linear_cruise_velocity");
@@ -1804,6 +2097,8 @@ void StateController::initParameters(void)
   params_.cruise_control_time_limit.init("cruise_control_time_limit");
   params_.overlapping_walkspaces.init("overlapping_walkspaces");
   params_.force_normal_touchdown.init("force_normal_touchdown");
+  params_.swing_optimisation.initOptional("swing_optimisation", false);
+  params_.adaptive_swing_timing.initOptional("adaptive_swing_timing", false);
   params_.gravity_aligned_tips.init("gravity_aligned_tips");
   params_.liftoff_threshold.init("liftoff_threshold");
   params_.touchdown_threshold.init("touchdown_threshold");
@@ -1832,6 +2127,8 @@ void StateController::initParameters(void)
 
   // Debug Parameters
   params_.debug_rviz.init("debug_rviz");
+  params_.debug_loop_timing.initOptional("debug_loop_timing", false);
+  params_.telemetry_rates.init("telemetry_rates", "/syropod/parameters/", false);
   params_.console_verbosity.init("console_verbosity");
   params_.debug_moveToJointPosition.init("debug_move_to_joint_position");
   params_.debug_stepToPosition.init("debug_step_to_position");
@@ -1858,7 +2155,7 @@ void StateController::initParameters(void)
       {
         ROS_FATAL("\nModel initialisation error for leg %s: Insufficient joint or link id's for defined DOF (%d).\n",
                   leg_id_name.c_str(), joint_count);
-        ros::shutdown();
+        fatal_error_ = true;
       }
       else
       {
@@ -1886,8 +2183,26 @@ void StateController::initParameters(void)
   params_.adjustable_map.insert(AdjustableMapType::value_type(VIRTUAL_DAMPING, &params_.virtual_damping_ratio));
   params_.adjustable_map.insert(AdjustableMapType::value_type(FORCE_GAIN, &params_.force_gain));
 
-  // Dynamic reconfigure server and callback setup
-  dynamic_reconfigure_server_ = new dynamic_reconfigure::Server<syropod_highlevel_controller::DynamicConfig>(mutex_);
+  if (!initGaitParameters(GAIT_UNDESIGNATED))
+  {
+    ROS_FATAL("\nUnable to initialise parameters of gait %s! Shutting down controller!\n",
+              params_.gait_type.data.c_str());
+    fatal_error_ = true;
+  }
+  initGaitDefinitions();
+  initAutoPoseParameters();
+
+  // Running headless (without a ros master) so skip dynamic reconfigure server setup
+  if (!private_node_handle_)
+  {
+    return;
+  }
+
+  // Dynamic reconfigure server and callback setup (serviced by the control thread via the control callback queue)
+  ros::NodeHandle reconfigure_node_handle(*private_node_handle_);
+  reconfigure_node_handle.setCallbackQueue(&control_callback_queue_);
+  dynamic_reconfigure_server_ =
+      new dynamic_reconfigure::Server<syropod_highlevel_controller::DynamicConfig>(mutex_, reconfigure_node_handle);
   dynamic_reconfigure::Server<syropod_highlevel_controller::DynamicConfig>::CallbackType callback_type;
   callback_type = boost::bind(&StateController::dynamicParameterCallback, this, _1, _2);
   dynamic_reconfigure_server_->setCallback(callback_type);
@@ -1926,41 +2241,111 @@ void StateController::initParameters(void)
   dynamic_reconfigure_server_->setConfigMin(config_min);
   dynamic_reconfigure_server_->setConfigDefault(config_default);
   dynamic_reconfigure_server_->updateConfig(config_default);
-
-  initGaitParameters(GAIT_UNDESIGNATED);
-  initAutoPoseParameters();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void StateController::initGaitParameters(const GaitDesignation &gait_selection)
+bool StateController::initGaitParameters(const GaitDesignation &gait_selection)
 {
-  switch (gait_selection)
-  {
-    case (TRIPOD_GAIT):
-      params_.gait_type.data = "tripod_gait";
-      break;
-    case (RIPPLE_GAIT):
-      params_.gait_type.data = "ripple_gait";
-      break;
-    case (WAVE_GAIT):
-      params_.gait_type.data = "wave_gait";
-      break;
-    case (AMBLE_GAIT):
-      params_.gait_type.data = "amble_gait";
-      break;
-    case (GAIT_UNDESIGNATED):
-      params_.gait_type.init("gait_type");
-      break;
-    default:
-      break;
+  if (gait_selection == GAIT_UNDESIGNATED)
+  {
+    params_.gait_type.init("gait_type");
+    return initGaitParameters(params_.gait_type.data);
+  }
+  else
+  {
+    return initGaitParameters(getGaitType(gait_selection));
   }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool StateController::initGaitParameters(const std::string &gait_type)
+{
+  params_.gait_type.data = gait_type;
   std::string base_gait_parameters_name = "/syropod/gait_parameters/";
   params_.stance_phase.init("stance_phase", base_gait_parameters_name + params_.gait_type.data + "/");
   params_.swing_phase.init("swing_phase", base_gait_parameters_name + params_.gait_type.data + "/");
   params_.phase_offset.init("phase_offset", base_gait_parameters_name + params_.gait_type.data + "/");
   params_.offset_multiplier.init("offset_multiplier", base_gait_parameters_name + params_.gait_type.data + "/");
+
+  // Resolve offset multipliers by leg id number so step cycle timing is free of leg name lookups
+  GaitDescriptor gait = { params_.stance_phase.data, params_.swing_phase.data, params_.phase_offset.data,
+                          static_cast<int>(params_.leg_id.data.size()), {} };
+  if (gait.leg_count > MAX_LEG_COUNT)
+  {
+    ROS_ERROR("\n[SHC] Unable to generate %s for %d legs. Gait definitions support at most %d legs.\n",
+              params_.gait_type.data.c_str(), gait.leg_count, MAX_LEG_COUNT);
+    return false;
+  }
+  for (int i = 0; i < gait.leg_count; ++i)
+  {
+    if (!params_.offset_multiplier.data.count(params_.leg_id.data[i]))
+    {
+      ROS_ERROR("\n[SHC] Gait parameters of %s do not define an offset multiplier for leg %s.\n",
+                params_.gait_type.data.c_str(), params_.leg_id.data[i].c_str());
+      return false;
+    }
+    gait.offset_multiplier[i] = params_.offset_multiplier.data.at(params_.leg_id.data[i]);
+  }
+
+  // Use compile time generated timing of matching built-in gait, otherwise generate timing of custom gait
+  int builtin_gait = 0;
+  while (builtin_gait < BUILTIN_GAIT_COUNT && !isEqualGait(gait, BUILTIN_GAITS[builtin_gait]))
+  {
+    builtin_gait++;
+  }
+  if (builtin_gait < BUILTIN_GAIT_COUNT)
+  {
+    params_.gait_table = BUILTIN_GAIT_TABLES[builtin_gait];
+  }
+  else
+  {
+    params_.gait_table = generateGaitTable(gait);
+    if (!isValidGait(params_.gait_table))
+    {
+      ROS_WARN("\n[SHC] Gait parameters of %s do not define a statically stable gait with a reference leg.\n",
+               params_.gait_type.data.c_str());
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StateController::initGaitDefinitions(void)
+{
+  gait_definitions_.clear();
+  XmlRpc::XmlRpcValue gait_parameters;
+  if (!getParameter("/syropod/gait_parameters", gait_parameters) ||
+      gait_parameters.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+  {
+    ROS_ERROR("\n[SHC] Error reading gait parameters from rosparam. Check config file is loaded.\n");
+    return;
+  }
+
+  std::string gait_type = params_.gait_type.data;
+  XmlRpc::XmlRpcValue::iterator it;
+  for (it = gait_parameters.begin(); it != gait_parameters.end(); ++it)
+  {
+    if (!initGaitParameters(it->first))
+    {
+      continue;
+    }
+    GaitDefinition gait;
+    gait.gait_type_ = it->first;
+    gait.gait_ = GAIT_UNDESIGNATED;
+    for (int i = 0; i < GAIT_DESIGNATION_COUNT; ++i)
+    {
+      GaitDesignation designation = static_cast<GaitDesignation>(i);
+      gait.gait_ = (getGaitType(designation) == gait.gait_type_ ? designation : gait.gait_);
+    }
+    gait.stance_phase_ = params_.stance_phase.data;
+    gait.swing_phase_ = params_.swing_phase.data;
+    gait.gait_table_ = params_.gait_table;
+    gait_definitions_.push_back(gait);
+  }
+  initGaitParameters(gait_type);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,42 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syropod_highlevel_controller/state_controller_nodelet.h"
+
+#include <pluginlib/class_list_macros.h>
+
+namespace syropod_highlevel_controller
+{
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StateControllerNodelet::~StateControllerNodelet(void)
+{
+  stop_ = true;
+  if (control_thread_.joinable())
+  {
+    control_thread_.join();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void StateControllerNodelet::onInit(void)
+{
+  // Acquisition of joint states and waiting for start are left to the control thread, as onInit must not block
+  state_ = std::make_shared<StateController>(getNodeHandle(), getPrivateNodeHandle());
+
+  // Note that console verbosity is process wide, i.e. applies to the manager and every nodelet loaded into it
+  configureConsoleVerbosity(state_->getParameters());
+  // Fatal controller errors end the control thread only, as shutting down ros would also stop the nodelet manager
+  control_thread_ = std::thread(runController, state_.get(), std::cref(stop_));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+}
+
+PLUGINLIB_EXPORT_CLASS(syropod_highlevel_controller::StateControllerNodelet, nodelet::Nodelet)
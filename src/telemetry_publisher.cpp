@@ -0,0 +1,625 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syropod_highlevel_controller/telemetry_publisher.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string getTelemetryTopicName(const TelemetryTopic &topic)
+{
+  static const char* topic_names[TELEMETRY_TOPIC_COUNT] = {
+    "leg_state", "velocity", "pose", "walkspace", "gait_selection", "odometry", "rotation_pose_error",
+    "frame_transforms",
+  };
+  return (topic >= 0 && topic < TELEMETRY_TOPIC_COUNT) ? topic_names[topic] : "undefined";
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TelemetryPublisher::TelemetryPublisher(ros::NodeHandle &node_handle, std::shared_ptr<Model> model,
+                                       const Parameters &params, tf2_ros::Buffer &transform_buffer,
+                                       std::shared_ptr<LoopProfiler> loop_profiler)
+  : transform_buffer_(transform_buffer)
+  , odom_available_(false)
+  , loop_profiler_(loop_profiler)
+  , telemetry_profiler_(std::make_shared<LoopProfiler>(loop_profiler->isEnabled(), params.time_delta.data))
+  , last_loop_timing_publish_(std::chrono::steady_clock::now())
+  , hardware_id_(params.syropod_type.data)
+  , time_delta_(params.time_delta.data)
+  , snapshots_(new TelemetrySnapshot[TELEMETRY_BUFFER_SIZE])
+  , head_(0)
+  , tail_(0)
+  , dropped_count_(0)
+  , shutdown_(false)
+{
+  // Topics missing from the telemetry rates parameter are published with every snapshot
+  const std::map<std::string, double> &rates = params.telemetry_rates.data;
+  for (int i = 0; i < TELEMETRY_TOPIC_COUNT; ++i)
+  {
+    std::map<std::string, double>::const_iterator rate_it = rates.find(getTelemetryTopicName(TelemetryTopic(i)));
+    topic_rates_[i] = (rate_it != rates.end()) ? rate_it->second : 1.0 / time_delta_;
+  }
+
+  // Topics published on change are latched so late subscribers receive the latest message
+  ros::NodeHandle &n = node_handle;
+  bool latch_walkspace = (topic_rates_[WALKSPACE_TOPIC] == 0.0);
+  bool latch_gait_selection = (topic_rates_[GAIT_SELECTION_TOPIC] == 0.0);
+  velocity_publisher_ = n.advertise<geometry_msgs::Twist>("/shc/velocity", 1000);
+  pose_publisher_ = n.advertise<geometry_msgs::Twist>("/shc/pose", 1000);
+  walkspace_publisher_ = n.advertise<std_msgs::Float32MultiArray>("/shc/walkspace", 1000, latch_walkspace);
+  rotation_pose_error_publisher_ = n.advertise<std_msgs::Float32MultiArray>("/shc/rotation_pose_error", 1000);
+  gait_selection_publisher_ =
+    n.advertise<std_msgs::Float32MultiArray>("/shc/gait_selection", 1000, latch_gait_selection);
+  odometry_publisher_ = n.advertise<nav_msgs::Odometry>("/shc/odometry", 1000);
+  if (loop_profiler_->isEnabled())
+  {
+    loop_timing_publisher_ = n.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 10);
+  }
+
+  // Copy constant names and DH parameters of each leg so the publisher thread never reads the shared model
+  LegContainer::iterator leg_it;
+  for (leg_it = model->getLegContainer()->begin(); leg_it != model->getLegContainer()->end(); ++leg_it)
+  {
+    // Legs exceeding the fixed size snapshot storage are excluded and stop the controller
+    std::shared_ptr<Leg> leg = leg_it->second;
+    if (leg->getIDNumber() < 0 || leg->getIDNumber() >= MAX_LEG_COUNT || leg->getJointCount() > MAX_JOINT_COUNT)
+    {
+      ROS_FATAL("\n[SHC] Leg %s exceeds telemetry limits of %d legs and %d joints per leg. Stopping controller.\n",
+                leg->getIDName().c_str(), MAX_LEG_COUNT, MAX_JOINT_COUNT);
+      model->setFatalError();
+      continue;
+    }
+    LegChain chain;
+    chain.leg_ = leg;
+    chain.name_ = leg->getIDName();
+    chain.joint_count_ = leg->getJointCount();
+    JointContainer::iterator joint_it;
+    for (joint_it = leg->getJointContainer()->begin(); joint_it != leg->getJointContainer()->end(); ++joint_it)
+    {
+      std::shared_ptr<Joint> joint = joint_it->second;
+      std::shared_ptr<Link> link = joint->reference_link_;
+      chain.frame_names_.push_back(joint->id_name_);
+      chain.dh_parameters_.push_back(Eigen::Vector4d(link->dh_parameter_d_, link->dh_parameter_theta_,
+                                                     link->dh_parameter_r_, link->dh_parameter_alpha_));
+      chain.actuating_joints_.push_back(link->actuating_joint_->id_number_ - 1);
+    }
+    std::shared_ptr<Tip> tip = leg->getTip();
+    std::shared_ptr<Link> link = tip->reference_link_;
+    chain.frame_names_.push_back(tip->id_name_);
+    chain.dh_parameters_.push_back(Eigen::Vector4d(link->dh_parameter_d_, link->dh_parameter_theta_,
+                                                   link->dh_parameter_r_, link->dh_parameter_alpha_));
+    chain.actuating_joints_.push_back(link->actuating_joint_->id_number_ - 1);
+
+    // Joint positions rotate each frame about its z axis after the constant offset from the parent frame
+    for (uint i = 0; i < chain.dh_parameters_.size(); ++i)
+    {
+      const Eigen::Vector4d &dh = chain.dh_parameters_[i];
+      chain.frame_offsets_.push_back(Pose::Identity().transform(createDHMatrix(dh[0], dh[1], dh[2], dh[3])));
+    }
+    leg_chains_.push_back(chain);
+  }
+  chain_poses_.reserve(MAX_JOINT_COUNT + 1);
+
+  // Set up batches of body frame transforms (walk_plane, then odom_ideal if required), joint frame transforms and
+  // static tip transforms
+  ros::Time now = ros::Time::now();
+  std::vector<geometry_msgs::TransformStamped> static_transforms;
+  geometry_msgs::TransformStamped base_link_to_walk_plane;
+  base_link_to_walk_plane.header.frame_id = "base_link";
+  base_link_to_walk_plane.child_frame_id = "walk_plane";
+  geometry_msgs::TransformStamped odom_ideal_to_base_link;
+  odom_ideal_to_base_link.header.frame_id = "odom_ideal";
+  odom_ideal_to_base_link.child_frame_id = "base_link";
+  body_transforms_.push_back(base_link_to_walk_plane);
+  body_transforms_.push_back(odom_ideal_to_base_link);
+  for (uint i = 0; i < leg_chains_.size(); ++i)
+  {
+    LegChain &chain = leg_chains_[i];
+    for (int j = 0; j < chain.joint_count_; ++j)
+    {
+      geometry_msgs::TransformStamped parent_to_joint;
+      parent_to_joint.header.frame_id = (j == 0) ? "base_link" : chain.frame_names_[j - 1];
+      parent_to_joint.child_frame_id = chain.frame_names_[j];
+      frame_transforms_.push_back(parent_to_joint);
+    }
+
+    geometry_msgs::TransformStamped joint_to_tip;
+    joint_to_tip.header.stamp = now;
+    joint_to_tip.header.frame_id = chain.frame_names_[chain.joint_count_ - 1];
+    joint_to_tip.child_frame_id = chain.frame_names_[chain.joint_count_];
+    joint_to_tip.transform = chain.frame_offsets_[chain.joint_count_].toTransformMessage();
+    static_transforms.push_back(joint_to_tip);
+  }
+  static_transform_broadcaster_.sendTransform(static_transforms);
+
+  thread_ = std::thread(&TelemetryPublisher::run, this);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TelemetryPublisher::~TelemetryPublisher(void)
+{
+  shutdown_.store(true, std::memory_order_relaxed);
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TelemetrySnapshot* TelemetryPublisher::beginCapture(void)
+{
+  int head = head_.load(std::memory_order_relaxed);
+  if ((head + 1) % TELEMETRY_BUFFER_SIZE == tail_.load(std::memory_order_acquire))
+  {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    return NULL;
+  }
+  return &snapshots_[head];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::endCapture(void)
+{
+  int head = head_.load(std::memory_order_relaxed);
+  head_.store((head + 1) % TELEMETRY_BUFFER_SIZE, std::memory_order_release);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::run(void)
+{
+  while (!shutdown_.load(std::memory_order_relaxed) && ros::ok())
+  {
+    unsigned long dropped_count = dropped_count_.exchange(0, std::memory_order_relaxed);
+    if (dropped_count > 0)
+    {
+      ROS_WARN_THROTTLE(THROTTLE_PERIOD, "\n[SHC] Telemetry publishing is lagging, dropped %lu snapshots.\n",
+                        dropped_count);
+    }
+
+    publishLoopTiming();
+    updateOdomAvailability();
+
+    // Sleep for a control loop period whenever all captured snapshots have been published
+    int tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire))
+    {
+      std::this_thread::sleep_for(std::chrono::duration<double>(time_delta_));
+      continue;
+    }
+
+    TelemetrySnapshot &snapshot = snapshots_[tail];
+    publishLegState(snapshot);
+    publishVelocity(snapshot);
+    publishPose(snapshot);
+    publishWalkspace(snapshot);
+    publishGaitSelection(snapshot);
+    publishOdometry(snapshot);
+    publishRotationPoseError(snapshot);
+    publishFrameTransforms(snapshot);
+    tail_.store((tail + 1) % TELEMETRY_BUFFER_SIZE, std::memory_order_release);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TelemetryPublisher::isDue(const TelemetryTopic &topic, const ros::Time &time)
+{
+  // Time moving backwards (e.g. restarted simulation) restarts the schedule
+  double rate = topic_rates_[topic];
+  double elapsed = (time - last_publish_times_[topic]).toSec();
+  if (rate <= 0.0 || (elapsed >= 0.0 && elapsed < 1.0 / rate - 0.5 * time_delta_))
+  {
+    return false;
+  }
+  last_publish_times_[topic] = time;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::updateOdomAvailability(void)
+{
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  bool first_check = (last_odom_check_ == std::chrono::steady_clock::time_point());
+  if (!first_check && std::chrono::duration<double>(now - last_odom_check_).count() < ODOM_CHECK_PERIOD)
+  {
+    return;
+  }
+  last_odom_check_ = now;
+
+  // Lookup is only attempted once canTransform succeeds, so only throws if the transform expires in between
+  bool odom_available = false;
+  if (transform_buffer_.canTransform("base_link", "odom", ros::Time(0)))
+  {
+    try
+    {
+      ros::Time stamp = transform_buffer_.lookupTransform("base_link", "odom", ros::Time(0)).header.stamp;
+      odom_available = (stamp.isZero() || (ros::Time::now() - stamp).toSec() < ODOM_TIMEOUT); // Zero stamp if static
+    }
+    catch (tf2::TransformException &ex)
+    {
+      odom_available = false;
+    }
+  }
+
+  bool previous_odom_available = odom_available_.exchange(odom_available, std::memory_order_relaxed);
+  if (odom_available && (first_check || !previous_odom_available))
+  {
+    ROS_INFO("\n[SHC] Odom transform found in tf tree - using odometry from perception\n");
+  }
+  else if (!odom_available && (first_check || previous_odom_available))
+  {
+    ROS_WARN("\n[SHC] No recent odom transform exists in tf tree - using ideal odometry\n");
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::applyFK(const LegChain &chain, const double* joint_positions,
+                                 std::vector<Pose, Eigen::aligned_allocator<Pose>> *poses)
+{
+  poses->clear();
+  Eigen::Matrix4d transform = Eigen::Matrix4d::Identity();
+  for (uint i = 0; i < chain.dh_parameters_.size(); ++i)
+  {
+    const Eigen::Vector4d &dh = chain.dh_parameters_[i];
+    int actuating_joint = chain.actuating_joints_[i];
+    double joint_angle = (actuating_joint < 0) ? 0.0 : joint_positions[actuating_joint];
+    transform = transform * createDHMatrix(dh[0], dh[1] + joint_angle, dh[2], dh[3]);
+    poses->push_back(Pose::Identity().transform(transform));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::publishLegState(TelemetrySnapshot &snapshot)
+{
+  ScopedStageTimer timer(*telemetry_profiler_, LEG_STATE_PUBLISH_STAGE);
+
+  if (!isDue(LEG_STATE_TOPIC, snapshot.time_))
+  {
+    return;
+  }
+
+  for (uint i = 0; i < leg_chains_.size(); ++i)
+  {
+    const LegChain &chain = leg_chains_[i];
+    if (chain.leg_->getStateSubscriberCount() == 0)
+    {
+      continue;
+    }
+
+    LegTelemetry &leg = snapshot.legs_[chain.leg_->getIDNumber()];
+    // Allocated per message on this (telemetry) thread, as intra-process subscribers may retain published messages
+    boost::shared_ptr<syropod_highlevel_controller::LegState> msg(new syropod_highlevel_controller::LegState());
+    msg->header.stamp = snapshot.time_;
+    msg->name = chain.name_;
+
+    // Tip poses
+    msg->walker_tip_pose.header.stamp = snapshot.time_;
+    msg->walker_tip_pose.header.frame_id = "walk_plane";
+    msg->walker_tip_pose.pose = leg.walker_tip_pose_.toPoseMessage();
+
+    msg->target_tip_pose.header.stamp = snapshot.time_;
+    msg->target_tip_pose.header.frame_id = "walk_plane";
+    msg->target_tip_pose.pose = leg.target_tip_pose_.toPoseMessage();
+
+    msg->poser_tip_pose.header.stamp = snapshot.time_;
+    msg->poser_tip_pose.header.frame_id = "base_link";
+    msg->poser_tip_pose.pose = leg.poser_tip_pose_.toPoseMessage();
+
+    msg->model_tip_pose.header.stamp = snapshot.time_;
+    msg->model_tip_pose.header.frame_id = "base_link";
+    msg->model_tip_pose.pose = leg.model_tip_pose_.toPoseMessage();
+
+    applyFK(chain, leg.current_positions_, &chain_poses_);
+    msg->actual_tip_pose.header.stamp = snapshot.time_;
+    msg->actual_tip_pose.header.frame_id = "base_link";
+    msg->actual_tip_pose.pose = chain_poses_.back().toPoseMessage();
+
+    // Tip velocities
+    msg->model_tip_velocity.header.stamp = snapshot.time_;
+    msg->model_tip_velocity.header.frame_id = "base_link";
+    msg->model_tip_velocity.twist.linear.x = leg.model_tip_velocity_[0];
+    msg->model_tip_velocity.twist.linear.y = leg.model_tip_velocity_[1];
+    msg->model_tip_velocity.twist.linear.z = leg.model_tip_velocity_[2];
+
+    // Joint positions/velocities
+    msg->joint_positions.assign(leg.desired_positions_, leg.desired_positions_ + chain.joint_count_);
+    msg->joint_velocities.assign(leg.desired_velocities_, leg.desired_velocities_ + chain.joint_count_);
+    msg->joint_efforts.assign(leg.desired_efforts_, leg.desired_efforts_ + chain.joint_count_);
+
+    // Step progress
+    msg->swing_progress = leg.swing_progress_;
+    msg->stance_progress = leg.stance_progress_;
+    msg->time_to_swing_end = leg.time_to_swing_end_;
+    msg->pose_delta = leg.pose_delta_.toPoseMessage();
+
+    // Leg specific auto pose
+    msg->auto_pose = leg.auto_pose_.toPoseMessage();
+
+    // Admittance controller
+    msg->tip_force.x = leg.tip_force_[0];
+    msg->tip_force.y = leg.tip_force_[1];
+    msg->tip_force.z = leg.tip_force_[2];
+    msg->admittance_delta.x = leg.admittance_delta_[0];
+    msg->admittance_delta.y = leg.admittance_delta_[1];
+    msg->admittance_delta.z = leg.admittance_delta_[2];
+    msg->virtual_stiffness = leg.virtual_stiffness_;
+
+    chain.leg_->publishState(msg);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::publishVelocity(TelemetrySnapshot &snapshot)
+{
+  ScopedStageTimer timer(*telemetry_profiler_, VELOCITY_PUBLISH_STAGE);
+
+  if (velocity_publisher_.getNumSubscribers() == 0 || !isDue(VELOCITY_TOPIC, snapshot.time_))
+  {
+    return;
+  }
+
+  geometry_msgs::Twist msg;
+  msg.linear.x = snapshot.desired_linear_velocity_[0];
+  msg.linear.y = snapshot.desired_linear_velocity_[1];
+  msg.linear.z = 0.0;
+  msg.angular.x = 0.0;
+  msg.angular.y = 0.0;
+  msg.angular.z = snapshot.desired_angular_velocity_;
+  velocity_publisher_.publish(msg);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::publishPose(TelemetrySnapshot &snapshot)
+{
+  ScopedStageTimer timer(*telemetry_profiler_, POSE_PUBLISH_STAGE);
+
+  if (pose_publisher_.getNumSubscribers() == 0 || !isDue(POSE_TOPIC, snapshot.time_))
+  {
+    return;
+  }
+
+  geometry_msgs::Twist msg;
+  Eigen::Vector3d position = snapshot.current_pose_.position_;
+  Eigen::Vector3d euler_angles = quaternionToEulerAngles(snapshot.current_pose_.rotation_);
+  msg.linear.x = position[0];
+  msg.linear.y = position[1];
+  msg.linear.z = position[2];
+  msg.angular.x = euler_angles[0];
+  msg.angular.y = euler_angles[1];
+  msg.angular.z = euler_angles[2];
+  pose_publisher_.publish(msg);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::publishWalkspace(TelemetrySnapshot &snapshot)
+{
+  ScopedStageTimer timer(*telemetry_profiler_, WALKSPACE_PUBLISH_STAGE);
+
+  if (!snapshot.running_)
+  {
+    return;
+  }
+  else if (topic_rates_[WALKSPACE_TOPIC] == 0.0)
+  {
+    double* walkspace_end = snapshot.walkspace_ + snapshot.walkspace_count_;
+    if (snapshot.walkspace_count_ == published_walkspace_count_ &&
+        std::equal(snapshot.walkspace_, walkspace_end, published_walkspace_))
+    {
+      return;
+    }
+    std::copy(snapshot.walkspace_, walkspace_end, published_walkspace_);
+    published_walkspace_count_ = snapshot.walkspace_count_;
+  }
+  else if (walkspace_publisher_.getNumSubscribers() == 0 || !isDue(WALKSPACE_TOPIC, snapshot.time_))
+  {
+    return;
+  }
+
+  std_msgs::Float32MultiArray msg;
+  for (int i = 0; i < snapshot.walkspace_count_; ++i)
+  {
+    msg.data.push_back(static_cast<float>(snapshot.walkspace_[i]));
+  }
+  walkspace_publisher_.publish(msg);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::publishGaitSelection(TelemetrySnapshot &snapshot)
+{
+  ScopedStageTimer timer(*telemetry_profiler_, GAIT_PUBLISH_STAGE);
+
+  if (!snapshot.running_ || !snapshot.gait_selection_defined_)
+  {
+    return;
+  }
+  else if (topic_rates_[GAIT_SELECTION_TOPIC] == 0.0)
+  {
+    if (std::equal(snapshot.gait_selection_, snapshot.gait_selection_ + 3, published_gait_selection_))
+    {
+      return;
+    }
+    std::copy(snapshot.gait_selection_, snapshot.gait_selection_ + 3, published_gait_selection_);
+  }
+  else if (gait_selection_publisher_.getNumSubscribers() == 0 || !isDue(GAIT_SELECTION_TOPIC, snapshot.time_))
+  {
+    return;
+  }
+
+  std_msgs::Float32MultiArray msg;
+  msg.data.push_back(static_cast<float>(snapshot.gait_selection_[0]));
+  msg.data.push_back(static_cast<float>(snapshot.gait_selection_[1]));
+  msg.data.push_back(static_cast<float>(snapshot.gait_selection_[2]));
+  gait_selection_publisher_.publish(msg);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::publishOdometry(TelemetrySnapshot &snapshot)
+{
+  ScopedStageTimer timer(*telemetry_profiler_, ODOMETRY_PUBLISH_STAGE);
+
+  if (odometry_publisher_.getNumSubscribers() == 0 || !isDue(ODOMETRY_TOPIC, snapshot.time_))
+  {
+    return;
+  }
+
+  nav_msgs::Odometry msg;
+  msg.header.stamp = snapshot.time_;
+  msg.header.frame_id = "odom_ideal";
+  msg.child_frame_id = "walk_plane";
+  msg.pose.pose = snapshot.odometry_ideal_.toPoseMessage();
+  msg.twist.twist.linear.x = snapshot.desired_linear_velocity_[0];
+  msg.twist.twist.linear.y = snapshot.desired_linear_velocity_[1];
+  msg.twist.twist.angular.z = snapshot.desired_angular_velocity_;
+
+  // Map planar covariance (x, y, yaw) into row-major 6x6 covariance (x, y, z, roll, pitch, yaw)
+  int index[3] = { 0, 1, 5 };
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      msg.pose.covariance[index[i] * 6 + index[j]] = snapshot.odometry_covariance_(i, j);
+    }
+  }
+  odometry_publisher_.publish(msg);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::publishRotationPoseError(TelemetrySnapshot &snapshot)
+{
+  ScopedStageTimer timer(*telemetry_profiler_, POSE_ERROR_PUBLISH_STAGE);
+
+  if (rotation_pose_error_publisher_.getNumSubscribers() == 0 || !isDue(ROTATION_POSE_ERROR_TOPIC, snapshot.time_))
+  {
+    return;
+  }
+
+  std_msgs::Float32MultiArray msg;
+  for (int i = 0; i < 3; ++i)
+  {
+    msg.data.push_back(static_cast<float>(snapshot.rotation_absement_error_[i]));
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    msg.data.push_back(static_cast<float>(snapshot.rotation_position_error_[i]));
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    msg.data.push_back(static_cast<float>(snapshot.rotation_velocity_error_[i]));
+  }
+  rotation_pose_error_publisher_.publish(msg);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::publishFrameTransforms(TelemetrySnapshot &snapshot)
+{
+  ScopedStageTimer timer(*telemetry_profiler_, TRANSFORM_PUBLISH_STAGE);
+
+  // Base Link frame to Walk Plane frame transform, published every cycle as required by external target lookups
+  Pose walk_plane_to_base_link = snapshot.current_pose_;
+  body_transforms_[0].header.stamp = snapshot.time_;
+  body_transforms_[0].transform = (~walk_plane_to_base_link).toTransformMessage();
+
+  // Broadcast ideal odom tf every cycle, if odom tf from perception does not exist on tf tree
+  bool odom_available = odom_available_.load(std::memory_order_relaxed);
+  body_transforms_.resize(odom_available ? 1 : 2);
+  if (!odom_available)
+  {
+    Pose odom_ideal_to_base_link = snapshot.odometry_ideal_.addPose(walk_plane_to_base_link);
+    body_transforms_[1].header.stamp = snapshot.time_;
+    body_transforms_[1].header.frame_id = "odom_ideal";
+    body_transforms_[1].child_frame_id = "base_link";
+    body_transforms_[1].transform = odom_ideal_to_base_link.toTransformMessage();
+  }
+  transform_broadcaster_.sendTransform(body_transforms_);
+
+  if (!isDue(FRAME_TRANSFORMS_TOPIC, snapshot.time_))
+  {
+    return;
+  }
+
+  // Parent frame to Joint frames, from desired joint positions
+  int index = 0;
+  for (uint i = 0; i < leg_chains_.size(); ++i)
+  {
+    const LegChain &chain = leg_chains_[i];
+    const LegTelemetry &leg = snapshot.legs_[chain.leg_->getIDNumber()];
+    for (int j = 0; j < chain.joint_count_; ++j)
+    {
+      const Pose &offset = chain.frame_offsets_[j];
+      Eigen::AngleAxisd joint_rotation(leg.desired_positions_[j], Eigen::Vector3d::UnitZ());
+      Eigen::Quaterniond rotation = offset.rotation_ * joint_rotation;
+      frame_transforms_[index].header.stamp = snapshot.time_;
+      frame_transforms_[index++].transform = Pose(offset.position_, rotation).toTransformMessage();
+    }
+  }
+
+  transform_broadcaster_.sendTransform(frame_transforms_);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TelemetryPublisher::publishLoopTiming(void)
+{
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (!loop_profiler_->isEnabled() ||
+      std::chrono::duration<double>(now - last_loop_timing_publish_).count() < LOOP_TIMING_PUBLISH_PERIOD)
+  {
+    return;
+  }
+  last_loop_timing_publish_ = now;
+
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+  for (int i = 0; i < UPDATE_STAGE_COUNT; ++i)
+  {
+    // Publishing stages are timed on this thread, all other stages on the control thread
+    UpdateStage stage = static_cast<UpdateStage>(i);
+    StageStatistics statistics = loop_profiler_->collect(stage);
+    StageStatistics telemetry_statistics = telemetry_profiler_->collect(stage);
+    if (telemetry_statistics.count > 0)
+    {
+      statistics = telemetry_statistics;
+    }
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = "shc: " + getUpdateStageName(stage) + " timing";
+    status.hardware_id = hardware_id_;
+    status.level = statistics.overrun_count > 0 ? diagnostic_msgs::DiagnosticStatus::WARN
+                                                : diagnostic_msgs::DiagnosticStatus::OK;
+    status.message = statistics.overrun_count > 0 ? "Exceeded control loop period" : "OK";
+    std::string values[] = { std::to_string(statistics.count), std::to_string(statistics.p50),
+                             std::to_string(statistics.p99), std::to_string(statistics.max),
+                             std::to_string(statistics.overrun_count) };
+    std::string keys[] = { "count", "p50 (s)", "p99 (s)", "max (s)", "overruns" };
+    for (int j = 0; j < 5; ++j)
+    {
+      diagnostic_msgs::KeyValue key_value;
+      key_value.key = keys[j];
+      key_value.value = values[j];
+      status.values.push_back(key_value);
+    }
+    msg.status.push_back(status);
+  }
+  loop_timing_publisher_.publish(msg);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syropod_highlevel_controller/terrain_map.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TerrainMap::TerrainMap(const Parameters &params)
+    : params_(params)
+{
+  int map_size = TERRAIN_MAP_TILE_SIZE * TERRAIN_MAP_TILE_COUNT;
+  map_.resize(map_size * map_size);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TerrainMap::clear(void)
+{
+  std::fill(map_.begin(), map_.end(), TerrainMapCell());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TerrainMapCell &TerrainMap::getCell(const int &x_index, const int &y_index)
+{
+  int map_size = TERRAIN_MAP_TILE_SIZE * TERRAIN_MAP_TILE_COUNT;
+  int x = mod(x_index, map_size);
+  int y = mod(y_index, map_size);
+  int tile = (x / TERRAIN_MAP_TILE_SIZE) * TERRAIN_MAP_TILE_COUNT + (y / TERRAIN_MAP_TILE_SIZE);
+  int cell = (x % TERRAIN_MAP_TILE_SIZE) * TERRAIN_MAP_TILE_SIZE + (y % TERRAIN_MAP_TILE_SIZE);
+  return map_[tile * TERRAIN_MAP_TILE_SIZE * TERRAIN_MAP_TILE_SIZE + cell];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TerrainMap::updateHeight(const Eigen::Vector3d &position)
+{
+  double resolution = params_.terrain_map_resolution.data;
+  int x_index = int(floor(position[0] / resolution));
+  int y_index = int(floor(position[1] / resolution));
+  TerrainMapCell &cell = getCell(x_index, y_index);
+  cell.x_index_ = x_index;
+  cell.y_index_ = y_index;
+  cell.height_ = position[2];
+  cell.defined_ = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+double TerrainMap::getHeight(const Eigen::Vector3d &position)
+{
+  double resolution = params_.terrain_map_resolution.data;
+  int x_index = int(floor(position[0] / resolution));
+  int y_index = int(floor(position[1] / resolution));
+  const TerrainMapCell &cell = getCell(x_index, y_index);
+  bool valid = cell.defined_ && cell.x_index_ == x_index && cell.y_index_ == y_index;
+  return valid ? cell.height_ : UNASSIGNED_VALUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
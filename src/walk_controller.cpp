@@ -9,6 +9,8 @@
 #include "syropod_highlevel_controller/walk_controller.h"
 #include "syropod_highlevel_controller/pose_controller.h"
 #include "syropod_highlevel_controller/debug_visualiser.h"
+#include "syropod_highlevel_controller/footstep_planner.h"
+#include "syropod_highlevel_controller/terrain_map.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -26,6 +28,11 @@ void WalkController::init(void)
   walk_plane_ = Eigen::Vector3d::Zero();
   walk_plane_normal_ = Eigen::Vector3d::UnitZ();
   odometry_ideal_ = Pose::Identity();
+  odometry_covariance_ = Eigen::Matrix3d::Zero();
+  stance_tip_positions_.clear();
+  legs_at_correct_phase_ = 0;
+  legs_completed_first_step_ = 0;
+  legs_walking_ = 0;
 
   // Set default stance tip positions from parameters
   for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
@@ -42,6 +49,8 @@ void WalkController::init(void)
     Pose identity_tip_pose(Eigen::Vector3d(x_position, y_position, 0.0), identity_tip_rotation);
     leg->setLegStepper(std::allocate_shared<LegStepper>(Eigen::aligned_allocator<LegStepper>(),
                                                         shared_from_this(), leg, identity_tip_pose));
+    leg->getLegStepper()->setStepState(FORCE_STOP);
+    legs_walking_ += int(leg->getLegState() == WALKING);
   }
 
   // Init velocity input variables
@@ -50,6 +59,10 @@ void WalkController::init(void)
 
   // Generate step timing
   generateStepCycle();
+
+  footstep_planner_ = std::allocate_shared<FootstepPlanner>(Eigen::aligned_allocator<FootstepPlanner>(),
+                                                            shared_from_this(), params_);
+  terrain_map_ = std::allocate_shared<TerrainMap>(Eigen::aligned_allocator<TerrainMap>(), params_);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -229,14 +242,13 @@ void WalkController::generateWalkspace(void)
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void WalkController::generateLimits(StepCycle step,
+                                    const GaitTable &gait_table,
                                     LimitMap *max_linear_speed_ptr,
                                     LimitMap *max_angular_speed_ptr,
                                     LimitMap *max_linear_acceleration_ptr,
                                     LimitMap *max_angular_acceleration_ptr)
 {
-  int base_step_period = params_.stance_phase.data + params_.swing_phase.data;
-  int normaliser = step.period_ / base_step_period;
-  int base_step_offset = int(params_.phase_offset.data * normaliser);
+  int normaliser = step.period_ / gait_table.base_step_period;
 
   bool set_limits = (!max_linear_speed_ptr && !max_linear_acceleration_ptr &&
                      !max_angular_speed_ptr && !max_angular_acceleration_ptr);
@@ -267,15 +279,19 @@ void WalkController::generateLimits(StepCycle step,
 
   // Set step offset and check if leg starts in swing period (i.e. forced to stance for the 1st step cycle)
   // If so find this max 'stance extension' period which is used in acceleration calculations
+  // NOTE: Phase offsets are only applied to leg steppers when setting walk controller limits, allowing limits to be
+  // generated for candidate step cycles without disturbing the current walk cycle.
   int max_stance_extension = 0;
+  std::vector<int> step_offsets;
   for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
   {
     std::shared_ptr<Leg> leg = leg_it_->second;
-    ROS_ASSERT(params_.offset_multiplier.data.count(leg->getIDName()));
-    int multiplier = params_.offset_multiplier.data.at(leg->getIDName());
-    std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
-    int step_offset = (base_step_offset * multiplier) % step.period_;
-    leg_stepper->setPhaseOffset(step_offset);
+    int step_offset = gait_table.phase_offsets[leg->getIDNumber()] * normaliser;
+    step_offsets.push_back(step_offset);
+    if (set_limits)
+    {
+      leg->getLegStepper()->setPhaseOffset(step_offset);
+    }
     if (step_offset > step.swing_start_ && step_offset < step.swing_end_) // SWING STATE
     {
       max_stance_extension = std::max(max_stance_extension, step.swing_end_ - step_offset);
@@ -285,48 +301,50 @@ void WalkController::generateLimits(StepCycle step,
   // Set max stride (i.e. max body velocity) to occur at end of 1st swing of leg with maximum stance period extension
   double time_to_max_stride = (max_stance_extension + step.stance_period_ + step.swing_period_) * time_delta_;
 
-  // Calculate initial max speed and acceleration of body
+  // Time: on_ground_ratio*(1/step_frequency_) where step frequency is FULL step cycles/s
+  double on_ground_ratio = double(step.stance_period_) / step.period_;
+  double stance_time = on_ground_ratio / step.frequency_;
+
+  // Calculates max overshoot of tip (in stance period) outside walkspace. Tip distances from default tip position are
+  // linear in max body speed (acceleration = max_speed / time_to_max_stride) so each leg contributes a constant
+  // overshoot coefficient per step cycle, independent of walkspace radius.
+  // All referenced swings are the LAST swing period BEFORE the max velocity (stride length) is reached
+  double stance_overshoot_coefficient = 0.0;
+  std::vector<int>::iterator offset_it;
+  for (offset_it = step_offsets.begin(); offset_it != step_offsets.end(); ++offset_it)
+  {
+    double t = (*offset_it) * time_delta_;              // Time between swing end and max velocity being reached
+    double time_to_swing_end = time_to_max_stride - t;
+    double v0 = time_to_swing_end / time_to_max_stride; // Tip velocity at time of swing end (per unit max speed)
+    double d0 = -v0 * stance_time / 2.0;                // Distance to default tip position at time of swing end
+    double d1 = d0 + v0 * t + 0.5 * sqr(t) / time_to_max_stride; // Distance from default tip position at max velocity
+    double d2 = step.stance_period_ * time_delta_ - t;            // Distance from default position at stance end
+    stance_overshoot_coefficient = std::max(stance_overshoot_coefficient, d1 + d2);
+  }
+  double swing_overshoot_coefficient = 0.5 * step.swing_period_ / (2.0 * step.period_ * step.frequency_);
+
+  // Scale walkspace to accomodate stance overshoot and normal swing overshoot. Since max speed is proportional to
+  // walkspace radius (max_speed = 2r / stance_time) the scaled radius reduces to a constant ratio of walkspace radius.
+  double stance_overshoot_ratio = std::max(0.0, 2.0 * stance_overshoot_coefficient / stance_time - 1.0);
+  double swing_overshoot_ratio = 2.0 * swing_overshoot_coefficient / stance_time;
+  double walkspace_scaler = 1.0 / (1.0 + stance_overshoot_ratio + swing_overshoot_ratio);
+
+  // Stance radius based around front right leg to ensure positive values
+  std::shared_ptr<Leg> reference_leg = model_->getLegByIDNumber(0);
+  std::shared_ptr<LegStepper> reference_leg_stepper = reference_leg->getLegStepper();
+  double x_position = reference_leg_stepper->getDefaultTipPose().position_[0];
+  double y_position = reference_leg_stepper->getDefaultTipPose().position_[1];
+  double stance_radius = Eigen::Vector2d(x_position, y_position).norm();
+
+  // Distance: scaled_walkspace_radius*2.0 (i.e. max stride length)
+  double linear_speed_scaler = (walkspace_scaler * 2.0) / stance_time;
+
+  // Populate limit maps for each walkspace radius
   LimitMap::iterator it;
   for (it = walkspace_.begin(); it != walkspace_.end(); ++it)
   {
     double walkspace_radius = it->second;
-    double on_ground_ratio = double(step.stance_period_) / step.period_;
-    double max_speed = (walkspace_radius * 2.0) / (on_ground_ratio / step.frequency_);
-    double max_acceleration = max_speed / time_to_max_stride;
-
-    // Calculates max overshoot of tip (in stance period) outside walkspace
-    double stance_overshoot = 0;
-    for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
-    {
-      std::shared_ptr<Leg> leg = leg_it_->second;
-      std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
-      // All referenced swings are the LAST swing period BEFORE the max velocity (stride length) is reached
-      double step_offset = leg_stepper->getPhaseOffset();
-      double t = step_offset * time_delta_; // Time between swing end and max velocity being reached
-      double time_to_swing_end = time_to_max_stride - t;
-      double v0 = max_acceleration * time_to_swing_end; // Tip velocity at time of swing end
-      double stride_length = v0 * (on_ground_ratio / step.frequency_);
-      double d0 = -stride_length / 2.0;                                          // Distance to default tip position at time of swing end
-      double d1 = d0 + v0 * t + 0.5 * max_acceleration * sqr(t);                 // Distance from default tip position at max velocity
-      double d2 = max_speed * (step.stance_period_ * time_delta_ - t);           // Distance from default position at stance end
-      stance_overshoot = std::max(stance_overshoot, d1 + d2 - walkspace_radius); // Max overshoot past walkspace limits
-    }
-
-    // Scale walkspace to accomodate stance overshoot and normal swing overshoot
-    double swing_overshoot = 0.5 * max_speed * step.swing_period_ / (2.0 * step.period_ * step.frequency_);
-    double scaled_walkspace_radius =
-        (walkspace_radius / (walkspace_radius + stance_overshoot + swing_overshoot)) * walkspace_radius;
-
-    // Stance radius based around front right leg to ensure positive values
-    std::shared_ptr<Leg> reference_leg = model_->getLegByIDNumber(0);
-    std::shared_ptr<LegStepper> reference_leg_stepper = reference_leg->getLegStepper();
-    double x_position = reference_leg_stepper->getDefaultTipPose().position_[0];
-    double y_position = reference_leg_stepper->getDefaultTipPose().position_[1];
-    double stance_radius = Eigen::Vector2d(x_position, y_position).norm();
-
-    // Distance: scaled_walkspace_radius*2.0 (i.e. max stride length)
-    // Time: on_ground_ratio*(1/step_frequency_) where step frequency is FULL step cycles/s)
-    double max_linear_speed = (scaled_walkspace_radius * 2.0) / (on_ground_ratio / step.frequency_);
+    double max_linear_speed = walkspace_radius * linear_speed_scaler;
     double max_linear_acceleration = max_linear_speed / time_to_max_stride;
     double max_angular_speed = max_linear_speed / stance_radius;
     double max_angular_acceleration = max_angular_speed / time_to_max_stride;
@@ -340,42 +358,67 @@ void WalkController::generateLimits(StepCycle step,
       max_angular_acceleration = UNASSIGNED_VALUE;
     }
 
-    // Populate limit maps
     if (max_linear_speed_ptr)
     {
-      max_linear_speed_ptr->insert(LimitMap::value_type(it->first, max_linear_speed));
+      max_linear_speed_ptr->insert(max_linear_speed_ptr->end(), LimitMap::value_type(it->first, max_linear_speed));
     }
     if (max_linear_acceleration_ptr)
     {
-      max_linear_acceleration_ptr->insert(LimitMap::value_type(it->first, max_linear_acceleration));
+      max_linear_acceleration_ptr->insert(max_linear_acceleration_ptr->end(),
+                                          LimitMap::value_type(it->first, max_linear_acceleration));
     }
     if (max_angular_speed_ptr)
     {
-      max_angular_speed_ptr->insert(LimitMap::value_type(it->first, max_angular_speed));
+      max_angular_speed_ptr->insert(max_angular_speed_ptr->end(), LimitMap::value_type(it->first, max_angular_speed));
     }
     if (max_angular_acceleration_ptr)
     {
-      max_angular_acceleration_ptr->insert(LimitMap::value_type(it->first, max_angular_acceleration));
+      max_angular_acceleration_ptr->insert(max_angular_acceleration_ptr->end(),
+                                           LimitMap::value_type(it->first, max_angular_acceleration));
     }
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-StepCycle WalkController::generateStepCycle(const bool set_step_cycle)
+StepCycle WalkController::generateStepCycle(const double &step_frequency, const bool set_step_cycle)
+{
+  StepCycle step = generateStepCycle(step_frequency, params_.gait_table);
+
+  // Set step cycle in walk controller and update phase in leg steppers for new parameters if required
+  if (set_step_cycle)
+  {
+    step_ = step;
+    if (walk_state_ == MOVING)
+    {
+      for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+      {
+        std::shared_ptr<Leg> leg = leg_it_->second;
+        std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
+        leg_stepper->updatePhase();
+      }
+    }
+  }
+  return step;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+StepCycle WalkController::generateStepCycle(const double &step_frequency, const GaitTable &gait_table)
 {
   StepCycle step;
-  step.stance_end_ = static_cast<int>(params_.stance_phase.data * 0.5);
-  step.swing_start_ = step.stance_end_;
-  step.swing_end_ = step.swing_start_ + params_.swing_phase.data;
-  step.stance_start_ = step.swing_end_;
+  step.stance_end_ = gait_table.stance_end;
+  step.swing_start_ = gait_table.swing_start;
+  step.swing_end_ = gait_table.swing_end;
+  step.stance_start_ = gait_table.stance_start;
 
   // Normalises the step period to match the total number of iterations over a full step
-  int base_step_period = params_.stance_phase.data + params_.swing_phase.data;
-  double swing_ratio = double(params_.swing_phase.data) / double(base_step_period); // Modifies step frequency
+  int base_step_period = gait_table.base_step_period;
+  int swing_phase = gait_table.swing_end - gait_table.swing_start;
+  double swing_ratio = double(swing_phase) / double(base_step_period); // Modifies step frequency
 
   // Ensure step period is even and divisible by base step period and therefore gives whole even normaliser value
-  double raw_step_period = ((1.0 / params_.step_frequency.current_value) / time_delta_) / swing_ratio;
+  double raw_step_period = ((1.0 / step_frequency) / time_delta_) / swing_ratio;
   step.period_ = roundToEvenInt(raw_step_period / base_step_period) * base_step_period;
 
   step.frequency_ = 1.0 / (step.period_ * time_delta_); // adjust step frequency to match corrected step period
@@ -391,22 +434,183 @@ StepCycle WalkController::generateStepCycle(const bool set_step_cycle)
   // Ensure stance and swing periods are divisible by two
   ROS_ASSERT(step.stance_period_ % 2 == 0);
   ROS_ASSERT(step.swing_period_ % 2 == 0);
+  return step;
+}
 
-  // Set step cycle in walk controller and update phase in leg steppers for new parameters if required
-  if (set_step_cycle)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WalkController::beginGaitTransition(void)
+{
+  // Store limits of previous gait
+  LimitMap previous_max_linear_speed = max_linear_speed_;
+  LimitMap previous_max_angular_speed = max_angular_speed_;
+  LimitMap previous_max_linear_acceleration = max_linear_acceleration_;
+  LimitMap previous_max_angular_acceleration = max_angular_acceleration_;
+
+  // Set new step cycle and map current phase of each leg into it
+  StepCycle previous_step = step_;
+  step_ = generateStepCycle(false);
+  for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
   {
-    step_ = step;
-    if (walk_state_ == MOVING)
+    std::shared_ptr<Leg> leg = leg_it_->second;
+    leg->getLegStepper()->mapPhase(previous_step);
+  }
+
+  // Generate limits and phase offsets of new gait
+  generateLimits();
+
+  // Limit velocities/accelerations to the minimum of both gaits for the duration of the transition
+  LimitMap::iterator it;
+  for (it = walkspace_.begin(); it != walkspace_.end(); ++it)
+  {
+    int bearing = it->first;
+    max_linear_speed_[bearing] = std::min(max_linear_speed_[bearing], previous_max_linear_speed[bearing]);
+    max_angular_speed_[bearing] = std::min(max_angular_speed_[bearing], previous_max_angular_speed[bearing]);
+    max_linear_acceleration_[bearing] =
+        std::min(max_linear_acceleration_[bearing], previous_max_linear_acceleration[bearing]);
+    max_angular_acceleration_[bearing] =
+        std::min(max_angular_acceleration_[bearing], previous_max_angular_acceleration[bearing]);
+  }
+
+  // Find reference leg about which the new phase offsets are aligned which minimises the largest phase correction
+  int half_period = step_.period_ / 2;
+  int min_max_correction = step_.period_;
+  std::shared_ptr<LegStepper> reference_leg_stepper;
+  LegContainer::iterator reference_it;
+  for (reference_it = model_->getLegContainer()->begin(); reference_it != model_->getLegContainer()->end();
+       ++reference_it)
+  {
+    std::shared_ptr<LegStepper> candidate = reference_it->second->getLegStepper();
+    int max_correction = 0;
+    for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
     {
-      for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
-      {
-        std::shared_ptr<Leg> leg = leg_it_->second;
-        std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
-        leg_stepper->updatePhase();
-      }
+      std::shared_ptr<LegStepper> leg_stepper = leg_it_->second->getLegStepper();
+      int target_phase = candidate->getPhase() - candidate->getPhaseOffset() + leg_stepper->getPhaseOffset();
+      int correction = mod(target_phase - leg_stepper->getPhase() + half_period, step_.period_) - half_period;
+      max_correction = std::max(max_correction, abs(correction));
+    }
+    if (max_correction < min_max_correction)
+    {
+      min_max_correction = max_correction;
+      reference_leg_stepper = candidate;
     }
   }
-  return step;
+
+  // Spread phase correction of each leg across the stance periods of the transition
+  int transition_stance_iterations = GAIT_TRANSITION_CYCLES * step_.stance_period_;
+  int max_delay = 0;
+  for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+  {
+    std::shared_ptr<LegStepper> leg_stepper = leg_it_->second->getLegStepper();
+    int target_phase =
+        reference_leg_stepper->getPhase() - reference_leg_stepper->getPhaseOffset() + leg_stepper->getPhaseOffset();
+    int correction = mod(target_phase - leg_stepper->getPhase() + half_period, step_.period_) - half_period;
+    int interval = (correction != 0 ? transition_stance_iterations / abs(correction) : 1);
+    leg_stepper->setPhaseCorrection(correction, interval);
+    max_delay = std::max(max_delay, -correction);
+  }
+  gait_transition_ = (min_max_correction != 0);
+
+  // Delays stretch stance periods at constant tip velocity, so reduce speed limits such that the longest stretched
+  // stance covers the nominal stride (holds beyond walkspace are deferred by each leg whilst velocity decelerates)
+  int max_stance_extension = (max_delay + GAIT_TRANSITION_CYCLES - 1) / GAIT_TRANSITION_CYCLES;
+  double stretch_scaler = double(step_.stance_period_) / (step_.stance_period_ + max_stance_extension);
+  for (it = walkspace_.begin(); it != walkspace_.end(); ++it)
+  {
+    max_linear_speed_[it->first] *= stretch_scaler;
+    max_angular_speed_[it->first] *= stretch_scaler;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WalkController::updateStepFrequency(const Eigen::Vector2d &linear_velocity_input,
+                                         const double &angular_velocity_input)
+{
+  frequency_transition_ = false;
+  std::string step_frequency_mode = params_.step_frequency_mode.data;
+  bool adaptive = (step_frequency_mode == "continuous" || step_frequency_mode == "cadence");
+  if (!adaptive || gait_transition_ || (walk_state_ != STOPPED && walk_state_ != MOVING))
+  {
+    return;
+  }
+
+  // Calculate target step frequency, scaling between parameter value and its maximum in cadence mode
+  double swing_ratio = double(params_.swing_phase.data) / (params_.stance_phase.data + params_.swing_phase.data);
+  double min_step_frequency = params_.step_frequency.current_value;
+  double target_step_frequency = min_step_frequency;
+  if (step_frequency_mode == "cadence")
+  {
+    double max_step_frequency = std::max(params_.step_frequency.max_value, min_step_frequency);
+    if (params_.velocity_input_mode.data == "throttle")
+    {
+      double throttle = std::min(std::max(linear_velocity_input.norm(), abs(angular_velocity_input)), 1.0);
+      target_step_frequency = min_step_frequency + throttle * (max_step_frequency - min_step_frequency);
+    }
+    else if (params_.velocity_input_mode.data == "real")
+    {
+      // Max speeds are proportional to step frequency so required frequency scales with proportion of max speed
+      double max_linear_speed = getLimit(linear_velocity_input, angular_velocity_input, max_linear_speed_);
+      double max_angular_speed = getLimit(linear_velocity_input, angular_velocity_input, max_angular_speed_);
+      double speed_ratio = 0.0;
+      speed_ratio += (max_linear_speed != 0.0 ? linear_velocity_input.norm() / max_linear_speed : 0.0);
+      speed_ratio += (max_angular_speed != 0.0 ? abs(angular_velocity_input) / max_angular_speed : 0.0);
+      target_step_frequency = (step_.frequency_ / swing_ratio) * (speed_ratio / CADENCE_SPEED_RATIO);
+    }
+    target_step_frequency = clamped(target_step_frequency, min_step_frequency, max_step_frequency);
+  }
+
+  StepCycle target_step = generateStepCycle(target_step_frequency, false);
+  if (target_step.period_ == step_.period_)
+  {
+    return;
+  }
+  else if (walk_state_ == STOPPED)
+  {
+    generateStepCycle(target_step_frequency, true);
+    generateLimits();
+    return;
+  }
+
+  // Check target limits accommodate current desired velocity, otherwise step down to the lowest frequency which does
+  generateLimits(target_step, &target_max_linear_speed_, &target_max_angular_speed_);
+  double max_linear_speed = getLimit(desired_linear_velocity_, desired_angular_velocity_, target_max_linear_speed_);
+  double max_angular_speed = getLimit(desired_linear_velocity_, desired_angular_velocity_, target_max_angular_speed_);
+  if (max_linear_speed == 0.0 || max_angular_speed == 0.0)
+  {
+    return;
+  }
+  double speed_ratio = std::max(desired_linear_velocity_.norm() / max_linear_speed,
+                                abs(desired_angular_velocity_) / max_angular_speed);
+  if (speed_ratio > 1.0)
+  {
+    frequency_transition_ = true;
+    target_step = generateStepCycle((target_step.frequency_ / swing_ratio) * speed_ratio, false);
+    if (target_step.period_ <= step_.period_)
+    {
+      return;
+    }
+    LimitMap max_linear_speed_map;
+    LimitMap max_angular_speed_map;
+    generateLimits(target_step, &max_linear_speed_map, &max_angular_speed_map);
+    if (desired_linear_velocity_.norm() > getLimit(desired_linear_velocity_, desired_angular_velocity_,
+                                                   max_linear_speed_map) ||
+        abs(desired_angular_velocity_) > getLimit(desired_linear_velocity_, desired_angular_velocity_,
+                                                  max_angular_speed_map))
+    {
+      return;
+    }
+  }
+
+  // Apply new step cycle and rescale leg phases in place (bezier time inputs are regenerated from step cycle)
+  StepCycle previous_step = step_;
+  step_ = target_step;
+  for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+  {
+    std::shared_ptr<Leg> leg = leg_it_->second;
+    leg->getLegStepper()->rescalePhase(previous_step);
+  }
+  generateLimits();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -423,27 +627,42 @@ double WalkController::getLimit(const Eigen::Vector2d &linear_velocity_input,
     Eigen::Vector3d tip_position = leg_stepper->getCurrentTipPose().position_;
     Eigen::Vector2d rotation_normal = Eigen::Vector2d(-tip_position[1], tip_position[0]);
     Eigen::Vector2d stride_vector = linear_velocity_input + angular_velocity_input * rotation_normal;
-    int bearing = mod(roundToInt(radiansToDegrees(atan2(stride_vector[1], stride_vector[0]))), 360);
-    int upper_bound = limit.lower_bound(bearing)->first;
-    int lower_bound = mod(upper_bound - BEARING_STEP, 360);
-    bearing += (bearing < lower_bound) ? 360 : 0;
-    upper_bound += (upper_bound < lower_bound) ? 360 : 0;
-    double control_input = (bearing - lower_bound) / (upper_bound - lower_bound);
-    double limit_interpolation = interpolate(limit.at(lower_bound), limit.at(mod(upper_bound, 360)), control_input);
-    min_limit = std::min(min_limit, limit_interpolation);
+    min_limit = std::min(min_limit, interpolateLimit(limit, stride_vector));
   }
   return min_limit;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+double WalkController::interpolateLimit(const LimitMap &limit, const Eigen::Vector2d &direction)
+{
+  // Limit maps hold bearings from 0 to 360 degrees inclusive, in increments of BEARING_STEP
+  int bearing = mod(roundToInt(radiansToDegrees(atan2(direction[1], direction[0]))), 360);
+  int upper_bound = limit.lower_bound(bearing)->first;
+  int lower_bound = (upper_bound == bearing ? bearing : upper_bound - BEARING_STEP);
+  double control_input = double(bearing - lower_bound) / BEARING_STEP;
+  return interpolate(limit.at(lower_bound), limit.at(upper_bound), control_input);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void WalkController::updateWalk(const Eigen::Vector2d &linear_velocity_input, const double &angular_velocity_input)
 {
   Eigen::Vector2d new_linear_velocity;
   double new_angular_velocity;
 
+  updateStepFrequency(linear_velocity_input, angular_velocity_input);
+
   double max_linear_speed = getLimit(linear_velocity_input, angular_velocity_input, max_linear_speed_);
   double max_angular_speed = getLimit(linear_velocity_input, angular_velocity_input, max_angular_speed_);
+  if (frequency_transition_)
+  {
+    // Restrict speed to limits of target step frequency whilst stepping down to it
+    max_linear_speed =
+        std::min(max_linear_speed, getLimit(linear_velocity_input, angular_velocity_input, target_max_linear_speed_));
+    max_angular_speed =
+        std::min(max_angular_speed, getLimit(linear_velocity_input, angular_velocity_input, target_max_angular_speed_));
+  }
   double max_linear_acceleration = getLimit(linear_velocity_input, angular_velocity_input, max_linear_acceleration_);
   double max_angular_acceleration = getLimit(linear_velocity_input, angular_velocity_input, max_angular_acceleration_);
 
@@ -489,19 +708,14 @@ void WalkController::updateWalk(const Eigen::Vector2d &linear_velocity_input, co
   bool has_velocity_command = linear_velocity_input.norm() || angular_velocity_input;
 
   // Check that all legs are in WALKING state
-  for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+  if (legs_walking_ != model_->getLegCount())
   {
-    std::shared_ptr<Leg> leg = leg_it_->second;
-    std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
-    if (leg->getLegState() != WALKING)
+    if (linear_velocity_input.norm())
     {
-      if (linear_velocity_input.norm())
-      {
-        ROS_INFO_THROTTLE(THROTTLE_PERIOD,
-                          "\nUnable to walk whilst manually manipulating legs, ensure each leg is in walking state.\n");
-      }
-      return;
+      ROS_INFO_THROTTLE(THROTTLE_PERIOD,
+                        "\nUnable to walk whilst manually manipulating legs, ensure each leg is in walking state.\n");
     }
+    return;
   }
 
   // Update linear velocity according to acceleration limits
@@ -527,11 +741,80 @@ void WalkController::updateWalk(const Eigen::Vector2d &linear_velocity_input, co
   }
 
   // State transitions for Walk State Machine
-  // State transition: STOPPED->STARTING
+  if (updateWalkState(has_velocity_command))
+  {
+    return; // Skips iteration of phase so auto posing can catch up
+  }
+
+  // Handle step cycle events for each leg (serially, as events modify state shared between legs)
+  for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+  {
+    std::shared_ptr<Leg> leg = leg_it_->second;
+    std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
+    handleEarlyTouchdown(leg);
+    int phase = leg_stepper->getPhase();
+    if (phase == step_.swing_start_ && leg_stepper->getStepState() == SWING)
+    {
+      handleSwingStart(leg);
+    }
+    else if (phase == step_.swing_end_ && walk_state_ != STOPPED)
+    {
+      handleSwingEnd(leg);
+    }
+  }
+
+  // Update tip position along trajectory for each leg (independent between legs so may be executed in parallel)
+  bool iterate_phase = (walk_state_ != STOPPED);
+  model_->updateLegs([iterate_phase](std::shared_ptr<Leg> leg)
+  {
+    std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
+    leg_stepper->updateTipPosition(); // Updates current tip position through step cycle
+    leg_stepper->updateTipRotation();
+    if (iterate_phase)
+    {
+      leg_stepper->iteratePhase();
+    }
+  });
+  // Complete gait transition and restore limits of new gait once all legs have corrected phase
+  if (gait_transition_)
+  {
+    bool transition_complete = true;
+    for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+    {
+      std::shared_ptr<LegStepper> leg_stepper = leg_it_->second->getLegStepper();
+      if (walk_state_ == STOPPED)
+      {
+        leg_stepper->setPhaseCorrection(0);
+      }
+      transition_complete = transition_complete && leg_stepper->getPhaseCorrection() == 0;
+    }
+    if (transition_complete)
+    {
+      gait_transition_ = false;
+      generateLimits();
+    }
+  }
+
+  updateWalkPlane();
+  updateOdometry();
+  if (regenerate_walkspace_)
+  {
+    generateWalkspace();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool WalkController::updateWalkState(const bool &has_velocity_command)
+{
   int leg_count = model_->getLegCount();
+
+  // State transition: STOPPED->STARTING
   if (walk_state_ == STOPPED && has_velocity_command)
   {
     walk_state_ = STARTING;
+    legs_at_correct_phase_ = 0;
+    legs_completed_first_step_ = 0;
     for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
     {
       std::shared_ptr<Leg> leg = leg_it_->second;
@@ -541,8 +824,20 @@ void WalkController::updateWalk(const Eigen::Vector2d &linear_velocity_input, co
       leg_stepper->setStepState(STANCE);
       leg_stepper->setPhase(leg_stepper->getPhaseOffset());
       leg_stepper->updateStepState();
+
+      // Force leg into STANCE if it starts offset in a mid-swing state (at correct phase once it reaches swing end)
+      int phase_offset = leg_stepper->getPhaseOffset();
+      if (phase_offset > step_.swing_start_ && phase_offset < step_.swing_end_)
+      {
+        leg_stepper->setStepState(FORCE_STANCE);
+      }
+      else
+      {
+        leg_stepper->setAtCorrectPhase(true);
+        legs_at_correct_phase_++;
+      }
     }
-    return; // Skips iteration of phase so auto posing can catch up
+    return true;
   }
   // State transition: STARTING->MOVING
   else if (walk_state_ == STARTING && legs_at_correct_phase_ == leg_count && legs_completed_first_step_ == leg_count)
@@ -550,6 +845,10 @@ void WalkController::updateWalk(const Eigen::Vector2d &linear_velocity_input, co
     legs_at_correct_phase_ = 0;
     legs_completed_first_step_ = 0;
     walk_state_ = MOVING;
+    for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+    {
+      leg_it_->second->getLegStepper()->setAtCorrectPhase(false);
+    }
   }
   // State transition: MOVING->STOPPING
   else if (walk_state_ == MOVING && !has_velocity_command)
@@ -561,94 +860,117 @@ void WalkController::updateWalk(const Eigen::Vector2d &linear_velocity_input, co
   {
     legs_at_correct_phase_ = 0;
     walk_state_ = STOPPED;
+    for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+    {
+      std::shared_ptr<LegStepper> leg_stepper = leg_it_->second->getLegStepper();
+      leg_stepper->setStepState(FORCE_STOP);
+      leg_stepper->setPhase(0);
+    }
+    footstep_planner_->clearFootsteps();
   }
+  return false;
+}
 
-  // Update walk/step state and tip position along trajectory for each leg
-  for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WalkController::handleSwingStart(std::shared_ptr<Leg> leg)
+{
+  // Plan footsteps as leg enters swing
+  if (params_.footstep_planning.data && walk_state_ == MOVING)
   {
-    std::shared_ptr<Leg> leg = leg_it_->second;
-    std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
+    footstep_planner_->planFootsteps(leg);
+  }
+}
 
-    // Walk State Machine
-    if (walk_state_ == STARTING)
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WalkController::handleSwingEnd(std::shared_ptr<Leg> leg)
+{
+  std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
+  if (walk_state_ == STARTING)
+  {
+    // Leg started offset in a mid-swing state and is now at correct phase
+    if (!leg_stepper->isAtCorrectPhase())
     {
-      // Check if all legs have completed one step
-      if (legs_at_correct_phase_ == leg_count)
-      {
-        if (leg_stepper->getPhase() == step_.swing_end_ && !leg_stepper->hasCompletedFirstStep())
-        {
-          leg_stepper->setCompletedFirstStep(true);
-          legs_completed_first_step_++;
-        }
-      }
-      // Force any leg state into STANCE if it starts offset in a mid-swing state but has not finished swing end
-      if (!leg_stepper->isAtCorrectPhase())
-      {
-        if (leg_stepper->getPhaseOffset() > step_.swing_start_ &&
-            leg_stepper->getPhaseOffset() < step_.swing_end_ && // SWING STATE
-            leg_stepper->getPhase() != step_.swing_end_)
-        {
-          leg_stepper->setStepState(FORCE_STANCE);
-        }
-        else
-        {
-          legs_at_correct_phase_++;
-          leg_stepper->setAtCorrectPhase(true);
-        }
-      }
+      leg_stepper->setAtCorrectPhase(true);
+      legs_at_correct_phase_++;
     }
-    else if (walk_state_ == MOVING)
+    // Leg completes first step once all legs are at correct phase
+    else if (legs_at_correct_phase_ == model_->getLegCount() && !leg_stepper->hasCompletedFirstStep())
     {
-      leg_stepper->setAtCorrectPhase(false);
+      leg_stepper->setCompletedFirstStep(true);
+      legs_completed_first_step_++;
+    }
+  }
+  else if (walk_state_ == MOVING)
+  {
+    // Record ground found at touchdown in terrain height map
+    if (params_.rough_terrain_mode.data && leg_stepper->getStepState() == STANCE)
+    {
+      terrain_map_->updateHeight(odometry_ideal_.transformVector(leg_stepper->getCurrentTipPose().position_));
     }
-    else if (walk_state_ == STOPPING)
+  }
+  else if (walk_state_ == STOPPING)
+  {
+    // All legs must attempt at least one step to achieve default tip position after ending a swing
+    bool zero_body_velocity = leg_stepper->getStrideVector().norm() == 0;
+    Eigen::Vector3d walk_plane_normal = leg_stepper->getWalkPlaneNormal();
+    Eigen::Vector3d error = (leg_stepper->getCurrentTipPose().position_ - leg_stepper->getTargetTipPose().position_);
+    error = getRejection(error, walk_plane_normal);
+    bool at_target_tip_position = (error.norm() < TIP_TOLERANCE);
+    if (zero_body_velocity && !leg_stepper->isAtCorrectPhase())
     {
-      // All legs must attempt at least one step to achieve default tip position after ending a swing
-      bool zero_body_velocity = leg_stepper->getStrideVector().norm() == 0;
-      Eigen::Vector3d walk_plane_normal = leg_stepper->getWalkPlaneNormal();
-      Eigen::Vector3d error = (leg_stepper->getCurrentTipPose().position_ - leg_stepper->getTargetTipPose().position_);
-      error = getRejection(error, walk_plane_normal);
-      bool at_target_tip_position = (error.norm() < TIP_TOLERANCE);
-      if (zero_body_velocity && !leg_stepper->isAtCorrectPhase() && leg_stepper->getPhase() == step_.swing_end_)
+      if (at_target_tip_position || return_to_default_attempted_)
       {
-        if (at_target_tip_position || return_to_default_attempted_)
-        {
-          return_to_default_attempted_ = false;
-          leg_stepper->updateDefaultTipPosition();
-          leg_stepper->setStepState(FORCE_STOP);
-          leg_stepper->setAtCorrectPhase(true);
-          legs_at_correct_phase_++;
-        }
-        else
-        {
-          return_to_default_attempted_ = true;
-        }
+        return_to_default_attempted_ = false;
+        leg_stepper->updateDefaultTipPosition();
+        leg_stepper->setStepState(FORCE_STOP);
+        leg_stepper->setAtCorrectPhase(true);
+        legs_at_correct_phase_++;
+      }
+      else
+      {
+        return_to_default_attempted_ = true;
       }
     }
-    else if (walk_state_ == STOPPED)
-    {
-      leg_stepper->setStepState(FORCE_STOP);
-      leg_stepper->setPhase(0.0);
-    }
+  }
+}
 
-    // Update tip positions
-    if (/*walk_state_ != STOPPED && */ leg->getLegState() == WALKING)
-    {
-      leg_stepper->updateTipPosition(); // Updates current tip position through step cycle
-      leg_stepper->updateTipRotation();
-      leg_stepper->iteratePhase();
-    }
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WalkController::handleEarlyTouchdown(std::shared_ptr<Leg> leg)
+{
+  std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
+  if (!params_.adaptive_swing_timing.data || walk_state_ != MOVING || gait_transition_ ||
+      leg_stepper->getStepState() != SWING || leg_stepper->getSwingProgress() <= 0.5 ||
+      leg_stepper->getPhaseCorrection() != 0)
+  {
+    return;
   }
-  updateWalkPlane();
-  odometry_ideal_ = odometry_ideal_.addPose(calculateOdometry(time_delta_));
-  if (regenerate_walkspace_)
+
+  // Touchdown is detected from measured tip force rather than step plane pose, which may be sensed prior to contact
+  if (leg->getTipForceMeasured().norm() > params_.touchdown_threshold.data)
   {
-    generateWalkspace();
+    leg_stepper->truncateSwing();
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void WalkController::setLegState(std::shared_ptr<Leg> leg, const LegState &leg_state)
+{
+  if (leg->getLegState() == WALKING && leg_state != WALKING)
+  {
+    legs_walking_--;
+  }
+  else if (leg->getLegState() != WALKING && leg_state == WALKING)
+  {
+    legs_walking_++;
+  }
+  leg->setLegState(leg_state);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 void WalkController::updateManual(const int &primary_leg_selection_ID,
                                   const Eigen::Vector3d &primary_tip_velocity_input,
                                   const int &secondary_leg_selection_ID,
@@ -780,18 +1102,146 @@ void WalkController::updateWalkPlane(void)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void WalkController::updateTerrainMap(std::shared_ptr<Leg> leg)
+{
+  Pose step_plane_pose = leg->getStepPlanePose();
+  std::shared_ptr<LegStepper> leg_stepper = leg->getLegStepper();
+  if (step_plane_pose != Pose::Undefined() && leg_stepper != NULL && leg->getLegState() == WALKING)
+  {
+    // Step plane pose is in robot frame - offset from current tip position into walk controller frame
+    Eigen::Vector3d step_plane_offset = step_plane_pose.position_ - leg->getCurrentTipPose().position_;
+    Eigen::Vector3d step_plane_position = leg_stepper->getCurrentTipPose().position_ + step_plane_offset;
+    terrain_map_->updateHeight(odometry_ideal_.transformVector(step_plane_position));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 Pose WalkController::calculateOdometry(const double &time_period)
 {
   Eigen::Vector3d desired_linear_velocity =
       Eigen::Vector3d(desired_linear_velocity_[0], desired_linear_velocity_[1], 0);
   Eigen::Vector3d position_delta = desired_linear_velocity * time_period;
-  Eigen::Quaterniond rotation_delta =
-      Eigen::Quaterniond(Eigen::AngleAxisd(desired_angular_velocity_ * time_period, Eigen::Vector3d::UnitZ()));
+  double angle_delta = desired_angular_velocity_ * time_period;
+
+  // Integrate along arc (SE(2) exponential map) rather than straight line in initial heading
+  if (angle_delta != 0.0)
+  {
+    double a = sin(angle_delta) / angle_delta;
+    double b = (1.0 - cos(angle_delta)) / angle_delta;
+    position_delta = Eigen::Vector3d(a * position_delta[0] - b * position_delta[1],
+                                     b * position_delta[0] + a * position_delta[1], 0.0);
+  }
+  Eigen::Quaterniond rotation_delta = Eigen::Quaterniond(Eigen::AngleAxisd(angle_delta, Eigen::Vector3d::UnitZ()));
   return Pose(position_delta, rotation_delta);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+Pose WalkController::calculateKinematicOdometry(int &stance_leg_count)
+{
+  // Pair actual tip positions (walk plane frame) of legs in stance over both this and the previous iteration
+  std::map<int, Eigen::Vector3d> stance_tip_positions;
+  std::vector<Eigen::Vector2d> previous_positions;
+  std::vector<Eigen::Vector2d> current_positions;
+  Pose walk_plane_to_base_link = model_->getCurrentPose();
+  for (leg_it_ = model_->getLegContainer()->begin(); leg_it_ != model_->getLegContainer()->end(); ++leg_it_)
+  {
+    std::shared_ptr<Leg> leg = leg_it_->second;
+    if (leg->getLegStepper()->getStepState() != STANCE)
+    {
+      continue;
+    }
+    Eigen::Vector3d tip_position = walk_plane_to_base_link.transformVector(leg->calculateActualTipPose().position_);
+    stance_tip_positions[leg->getIDNumber()] = tip_position;
+    if (stance_tip_positions_.count(leg->getIDNumber()))
+    {
+      Eigen::Vector3d previous_tip_position = stance_tip_positions_.at(leg->getIDNumber());
+      previous_positions.push_back(Eigen::Vector2d(previous_tip_position[0], previous_tip_position[1]));
+      current_positions.push_back(Eigen::Vector2d(tip_position[0], tip_position[1]));
+    }
+  }
+  stance_tip_positions_ = stance_tip_positions;
+  stance_leg_count = previous_positions.size();
+  if (stance_leg_count < 2)
+  {
+    return Pose::Identity();
+  }
+
+  // Find planar rigid transform mapping current tip positions onto previous (stance tips are fixed on the ground)
+  Eigen::Vector2d previous_centroid(0.0, 0.0);
+  Eigen::Vector2d current_centroid(0.0, 0.0);
+  for (int i = 0; i < stance_leg_count; ++i)
+  {
+    previous_centroid += previous_positions[i] / stance_leg_count;
+    current_centroid += current_positions[i] / stance_leg_count;
+  }
+  double sin_sum = 0.0;
+  double cos_sum = 0.0;
+  for (int i = 0; i < stance_leg_count; ++i)
+  {
+    Eigen::Vector2d p = current_positions[i] - current_centroid;
+    Eigen::Vector2d q = previous_positions[i] - previous_centroid;
+    sin_sum += p[0] * q[1] - p[1] * q[0];
+    cos_sum += p[0] * q[0] + p[1] * q[1];
+  }
+  double angle_delta = atan2(sin_sum, cos_sum);
+  Eigen::Vector2d position_delta = previous_centroid - Eigen::Rotation2Dd(angle_delta) * current_centroid;
+  return Pose(Eigen::Vector3d(position_delta[0], position_delta[1], 0.0),
+              Eigen::Quaterniond(Eigen::AngleAxisd(angle_delta, Eigen::Vector3d::UnitZ())));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WalkController::updateOdometry(void)
+{
+  Pose odometry_delta = calculateOdometry(time_delta_);
+  double angle_delta = desired_angular_velocity_ * time_delta_;
+  double linear_variance = ODOMETRY_LINEAR_NOISE * odometry_delta.position_.norm();
+  double angular_variance = ODOMETRY_ANGULAR_NOISE * abs(angle_delta);
+
+  // Fuse ideal change in pose with kinematic estimate according to relative variance
+  if (params_.odometry_fusion.data)
+  {
+    int stance_leg_count = 0;
+    Pose kinematic_delta = calculateKinematicOdometry(stance_leg_count);
+    if (stance_leg_count >= 2 && walk_state_ != STOPPED)
+    {
+      double kinematic_variance = KINEMATIC_ODOMETRY_NOISE / stance_leg_count;
+      double linear_gain = linear_variance / (linear_variance + kinematic_variance);
+      double angular_gain = angular_variance / (angular_variance + kinematic_variance);
+      double kinematic_angle_delta = quaternionToEulerAngles(kinematic_delta.rotation_)[2];
+      double angle_error = kinematic_angle_delta - angle_delta;
+      angle_delta += angular_gain * atan2(sin(angle_error), cos(angle_error));
+      odometry_delta.position_ += linear_gain * (kinematic_delta.position_ - odometry_delta.position_);
+      odometry_delta.rotation_ = Eigen::Quaterniond(Eigen::AngleAxisd(angle_delta, Eigen::Vector3d::UnitZ()));
+      linear_variance *= (1.0 - linear_gain);
+      angular_variance *= (1.0 - angular_gain);
+    }
+  }
+  else
+  {
+    stance_tip_positions_.clear();
+  }
+
+  // Propagate covariance through planar motion model (Jacobians w.r.t. previous pose and change in pose)
+  double yaw = quaternionToEulerAngles(odometry_ideal_.rotation_)[2];
+  double x_delta = odometry_delta.position_[0];
+  double y_delta = odometry_delta.position_[1];
+  Eigen::Matrix3d pose_jacobian = Eigen::Matrix3d::Identity();
+  pose_jacobian(0, 2) = -sin(yaw) * x_delta - cos(yaw) * y_delta;
+  pose_jacobian(1, 2) = cos(yaw) * x_delta - sin(yaw) * y_delta;
+  Eigen::Matrix3d delta_jacobian = Eigen::Matrix3d::Identity();
+  delta_jacobian.block<2, 2>(0, 0) = Eigen::Rotation2Dd(yaw).toRotationMatrix();
+  Eigen::Matrix3d delta_covariance = Eigen::Vector3d(linear_variance, linear_variance, angular_variance).asDiagonal();
+  odometry_covariance_ = pose_jacobian * odometry_covariance_ * pose_jacobian.transpose() +
+                         delta_jacobian * delta_covariance * delta_jacobian.transpose();
+
+  odometry_ideal_ = odometry_ideal_.addPose(odometry_delta);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 LegStepper::LegStepper(std::shared_ptr<WalkController> walker, std::shared_ptr<Leg> leg, const Pose &identity_tip_pose)
     : walker_(walker)
     , leg_(leg)
@@ -808,6 +1258,7 @@ LegStepper::LegStepper(std::shared_ptr<WalkController> walker, std::shared_ptr<L
   swing_origin_tip_position_ = default_tip_pose_.position_;
   stance_origin_tip_position_ = default_tip_pose_.position_;
   swing_clearance_ = Eigen::Vector3d(0.0, 0.0, walker->getStepClearance());
+  swing_apex_position_ = default_tip_pose_.position_ + swing_clearance_;
 
   // Iterate through and initialise control nodes (5 control nodes for quartic (4th order) bezier curves)
   for (int i = 0; i < 5; ++i)
@@ -837,16 +1288,22 @@ LegStepper::LegStepper(std::shared_ptr<LegStepper> leg_stepper)
   swing_origin_tip_velocity_ = leg_stepper->swing_origin_tip_velocity_;
   stance_origin_tip_position_ = leg_stepper->stance_origin_tip_position_;
   swing_clearance_ = leg_stepper->swing_clearance_;
+  swing_apex_position_ = leg_stepper->swing_apex_position_;
   at_correct_phase_ = leg_stepper->at_correct_phase_;
   completed_first_step_ = leg_stepper->completed_first_step_;
   phase_ = leg_stepper->phase_;
   phase_offset_ = leg_stepper->phase_offset_;
+  phase_correction_ = leg_stepper->phase_correction_;
+  phase_correction_interval_ = leg_stepper->phase_correction_interval_;
+  phase_correction_count_ = leg_stepper->phase_correction_count_;
+  stance_velocity_scaler_ = leg_stepper->stance_velocity_scaler_;
   stance_progress_ = leg_stepper->stance_progress_;
   swing_progress_ = leg_stepper->swing_progress_;
   stance_progress_ = leg_stepper->stance_progress_;
   step_state_ = leg_stepper->step_state_;
   swing_delta_t_ = leg_stepper->swing_delta_t_;
   stance_delta_t_ = leg_stepper->stance_delta_t_;
+  linear_stance_ = leg_stepper->linear_stance_;
 
   // Iterate through and initialise control nodes (5 control nodes for quartic (4th order) bezier curves)
   for (int i = 0; i < 5; ++i)
@@ -871,7 +1328,23 @@ void LegStepper::updatePhase(void)
 void LegStepper::iteratePhase(void)
 {
   StepCycle step = walker_->getStepCycle();
-  phase_ = (phase_ + 1) % (step.period_);
+  int phase_increment = 1;
+
+  // Apply phase correction by holding (stretch) or skipping (shorten) an iteration strictly within stance period. The
+  // tip continues at stance velocity whilst held, so holds which would carry it beyond the walkspace are deferred.
+  if (phase_correction_ != 0 && step_state_ == STANCE && phase_ != step.stance_start_)
+  {
+    int stance_iteration = mod(phase_ - step.stance_start_, step.period_);
+    if (stance_iteration + 2 < step.stance_period_ && ++phase_correction_count_ >= phase_correction_interval_ &&
+        (phase_correction_ > 0 || isStanceExtensionPermitted(1)))
+    {
+      phase_correction_count_ = 0;
+      phase_increment = (phase_correction_ > 0 ? 2 : 0);
+      phase_correction_ -= sign(phase_correction_);
+    }
+  }
+
+  phase_ = (phase_ + phase_increment) % (step.period_);
   updateStepState();
 
   // Calculate progress of stance/swing periods (0.0->1.0 or -1.0 if not in specific state)
@@ -898,6 +1371,95 @@ void LegStepper::iteratePhase(void)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void LegStepper::truncateSwing(void)
+{
+  StepCycle step = walker_->getStepCycle();
+  int truncated_iterations = step.swing_end_ - phase_;
+
+  phase_ = step.swing_end_;
+  step_progress_ = double(phase_) / step.period_;
+  updateStepState();
+  swing_progress_ = -1.0;
+  stance_progress_ = 0.0;
+
+  // Re-bound stance stroke against current walkspace limits - if the stroke over the extended stance period would leave
+  // the walkspace, the tip is slowed such that it completes only the stroke of an unextended stance period
+  stance_velocity_scaler_ = 1.0;
+  if (!isStanceExtensionPermitted(truncated_iterations))
+  {
+    stance_velocity_scaler_ = double(step.stance_period_) / (step.stance_period_ + truncated_iterations);
+  }
+
+  // Spread stance delay over first half of stance period (phase correction only applies strictly within stance)
+  int interval = (step.stance_period_ - 2) / (2 * truncated_iterations);
+  setPhaseCorrection(-truncated_iterations, interval);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LegStepper::mapPhase(const StepCycle &previous_step)
+{
+  StepCycle step = walker_->getStepCycle();
+  if (step_state_ == SWING)
+  {
+    double progress = double(phase_ - previous_step.swing_start_) / previous_step.swing_period_;
+    int swing_iteration = roundToInt(progress * step.swing_period_);
+    phase_ = step.swing_start_ + clamped(swing_iteration, 0, step.swing_period_ - 1);
+  }
+  else
+  {
+    double progress = double(mod(phase_ - previous_step.stance_start_, previous_step.period_)) /
+                      previous_step.stance_period_;
+    int stance_iteration = roundToInt(progress * step.stance_period_);
+    phase_ = mod(step.stance_start_ + clamped(stance_iteration, 0, step.stance_period_ - 1), step.period_);
+  }
+  step_progress_ = double(phase_) / step.period_;
+  updateStepState();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LegStepper::isStanceExtensionPermitted(const int &extension)
+{
+  StepCycle step = walker_->getStepCycle();
+  int remaining_iterations = mod(step.stance_end_ - phase_, step.period_) + extension;
+  Eigen::Vector3d stance_end_position = current_tip_pose_.position_ -
+      stride_vector_ * stance_velocity_scaler_ * (double(remaining_iterations) / step.stance_period_);
+  Eigen::Vector3d offset = getRejection(stance_end_position - default_tip_pose_.position_, walk_plane_normal_);
+  if (offset.norm() == 0.0)
+  {
+    return true;
+  }
+
+  Eigen::Vector2d planar_offset(offset[0], offset[1]);
+  return offset.norm() <= walker_->interpolateLimit(walker_->getWalkspace(), planar_offset);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LegStepper::rescalePhase(const StepCycle &previous_step)
+{
+  StepCycle step = walker_->getStepCycle();
+  const Parameters &params = walker_->getParameters();
+  int base_step_period = params.gait_table.base_step_period;
+  int previous_normaliser = previous_step.period_ / base_step_period;
+  int normaliser = step.period_ / base_step_period;
+
+  // Phase offsets are multiples of the normaliser so all legs share the same iteration within their segment
+  int segment = phase_ / previous_normaliser;
+  int segment_iteration = phase_ % previous_normaliser;
+  if (segment_iteration != 0)
+  {
+    double scaled_iteration = double(segment_iteration * normaliser) / previous_normaliser;
+    segment_iteration = clamped(roundToInt(scaled_iteration), 1, normaliser - 1);
+  }
+  phase_ = segment * normaliser + segment_iteration;
+  step_progress_ = double(phase_) / step.period_;
+  updateStepState();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void LegStepper::updateStepState(void)
 {
   // Update step state from phase unless force stopped
@@ -1055,22 +1617,33 @@ void LegStepper::updateTipPosition(void)
     {
       swing_origin_tip_position_ = current_tip_pose_.position_;
       swing_origin_tip_velocity_ = current_tip_velocity_;
+      stance_velocity_scaler_ = 1.0;
       if (rough_terrain_mode)
       {
         updateDefaultTipPosition();
       }
     }
 
+    // Shift target within walk plane to footstep planned in-process (held in odom_ideal frame)
+    if (external_target_.defined_ && external_target_.planned_)
+    {
+      // Compose full predicted odometry (incl. rotation) to swing end such that planned targets hold whilst turning
+      double time_to_swing_end = (swing_iterations - iteration) * time_delta;
+      Pose odometry = walker_->getOdometryIdeal().addPose(walker_->calculateOdometry(time_to_swing_end));
+      Eigen::Vector3d planned_position = odometry.inverseTransformVector(external_target_.pose_.position_);
+      target_tip_pose_.position_ += getRejection(planned_position - target_tip_pose_.position_, walk_plane_normal_);
+    }
+
     // Update target to externally defined position OR update default to meet step surface
     if (rough_terrain_mode)
     {
       // Update target tip pose to externally requested target tip pose transformed based on movement since request
-      if (external_target_.defined_)
+      if (external_target_.defined_ && !external_target_.planned_)
       {
         target_tip_pose_ = external_target_.pose_.removePose(external_target_.transform_);
         swing_clearance_ = swing_clearance_.normalized() * external_target_.swing_clearance_;
         // Add lead to compensate for moving target
-        if (external_target_.frame_id_ == "odom_ideal")
+        if (external_target_.frame_id_ == ODOM_IDEAL_FRAME_ID)
         {
           double time_to_swing_end = (swing_iterations - iteration) * time_delta;
           Eigen::Vector3d target_lead = walker_->calculateOdometry(time_to_swing_end).position_;
@@ -1093,10 +1666,27 @@ void LegStepper::updateTipPosition(void)
           Eigen::Vector3d difference = target_tip_position - target_tip_pose_.position_;
           target_tip_pose_.position_ += getProjection(difference, walk_plane_normal_);
         }
-        // Shift target toward step surface by defined distance and rely on step surface contact detection (REACTIVE)
-        else 
+        else
         {
-          target_tip_pose_.position_ -= walker_->getStepDepth() * Eigen::Vector3d::UnitZ();
+          // Query terrain height map at target tip position in odom_ideal frame (with lead to end of swing)
+          Pose odometry = walker_->getOdometryIdeal();
+          double time_to_swing_end = (swing_iterations - iteration) * time_delta;
+          Eigen::Vector3d target_lead = walker_->calculateOdometry(time_to_swing_end).position_;
+          Eigen::Vector3d mapped_position = odometry.transformVector(target_tip_pose_.position_ + target_lead);
+          mapped_position[2] = walker_->getTerrainMap()->getHeight(mapped_position);
+
+          // Shift target to step surface previously found in area according to terrain height map (PROACTIVE)
+          if (mapped_position[2] != UNASSIGNED_VALUE)
+          {
+            Eigen::Vector3d target_tip_position = odometry.inverseTransformVector(mapped_position) - target_lead;
+            Eigen::Vector3d difference = target_tip_position - target_tip_pose_.position_;
+            target_tip_pose_.position_ += getProjection(difference, walk_plane_normal_);
+          }
+          // Shift target toward step surface by defined distance and rely on step surface contact detection (REACTIVE)
+          else
+          {
+            target_tip_pose_.position_ -= walker_->getStepDepth() * Eigen::Vector3d::UnitZ();
+          }
         }
       }
       else
@@ -1106,6 +1696,12 @@ void LegStepper::updateTipPosition(void)
       }
     }
 
+    // Optimise swing trajectory apex once targets for this swing period are set
+    if (iteration == 1 && walker_->getParameters().swing_optimisation.data)
+    {
+      optimiseSwingApex();
+    }
+
     // Generate swing control nodes (once at beginning of 1st half and continuously for 2nd half)
     bool ground_contact = (leg_->getStepPlanePose() != Pose::Undefined() && rough_terrain_mode);
     generatePrimarySwingControlNodes();
@@ -1165,12 +1761,21 @@ void LegStepper::updateTipPosition(void)
 
     // Scales stride vector according to stance period specifically for STARTING state of walker
     double stride_scaler = double(modified_stance_period) / (mod(step.stance_end_ - step.stance_start_, step.period_));
-    generateStanceControlNodes(stride_scaler);
+    generateStanceControlNodes(stride_scaler * stance_velocity_scaler_);
 
     // Uses derivative of bezier curve to ensure correct velocity along ground, this means the position may not
     // reach the target but this is less important than ensuring correct velocity according to stride vector
+    // Derivative of curve with evenly spaced collinear nodes is constant (4x node seperation) so is not evaluated
     double time_input = iteration * stance_delta_t_;
-    Eigen::Vector3d delta_pos = stance_delta_t_ * quarticBezierDot(stance_nodes_, time_input);
+    Eigen::Vector3d delta_pos;
+    if (linear_stance_)
+    {
+      delta_pos = stance_delta_t_ * 4.0 * (stance_nodes_[1] - stance_nodes_[0]);
+    }
+    else
+    {
+      delta_pos = stance_delta_t_ * quarticBezierDot(stance_nodes_, time_input);
+    }
     ROS_ASSERT(delta_pos.norm() < UNASSIGNED_VALUE);
     current_tip_pose_.position_ += delta_pos;
     current_tip_velocity_ = delta_pos / walker_->getTimeDelta();
@@ -1258,6 +1863,16 @@ void LegStepper::generatePrimarySwingControlNodes(void)
   swing_1_nodes_[3][2] = mid_tip_position[2];
   // Set to default tip position so max swing height and transition to 2nd swing curve occurs at default tip position
   swing_1_nodes_[4] = mid_tip_position;
+
+  // Replace heuristic apex with optimised apex (C2 Smoothness at transition between swing curves for any apex)
+  if (walker_->getParameters().swing_optimisation.data)
+  {
+    Eigen::Vector3d final_tip_velocity = -stride_vector_ * (stance_delta_t_ / walker_->getTimeDelta());
+    Eigen::Vector3d final_node_seperation = 0.25 * final_tip_velocity * (walker_->getTimeDelta() / swing_delta_t_);
+    Eigen::Vector3d secondary_node = target_tip_pose_.position_ - 2.0 * final_node_seperation;
+    swing_1_nodes_[3] = swing_apex_position_ + (swing_1_nodes_[2] - secondary_node) / 4.0;
+    swing_1_nodes_[4] = swing_apex_position_;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1307,6 +1922,186 @@ void LegStepper::generateStanceControlNodes(const double &stride_scaler)
   stance_nodes_[3] = stance_origin_tip_position_ + 3.0 * stance_node_seperation;
   // Set as target tip position
   stance_nodes_[4] = stance_origin_tip_position_ + 4.0 * stance_node_seperation;
+
+  linear_stance_ = isLinearStance();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool LegStepper::isLinearStance(void)
+{
+  Eigen::Vector3d stance_node_seperation = stance_nodes_[1] - stance_nodes_[0];
+  for (int i = 2; i < 5; ++i)
+  {
+    if ((stance_nodes_[i] - stance_nodes_[i - 1] - stance_node_seperation).norm() > STANCE_NODE_TOLERANCE)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void LegStepper::optimiseSwingApex(void)
+{
+  double time_delta = walker_->getTimeDelta();
+  double half_swing_time = time_delta / swing_delta_t_;
+
+  // Control nodes fixed by boundary conditions at swing origin (p) and swing target (q)
+  Eigen::Vector3d origin_node_seperation = 0.25 * swing_origin_tip_velocity_ * half_swing_time;
+  Eigen::Vector3d final_tip_velocity = -stride_vector_ * (stance_delta_t_ / time_delta);
+  Eigen::Vector3d final_node_seperation = 0.25 * final_tip_velocity * half_swing_time;
+  Eigen::Vector3d p[3];
+  Eigen::Vector3d q[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    p[i] = swing_origin_tip_position_ + i * origin_node_seperation;
+    q[i] = target_tip_pose_.position_ - (2 - i) * final_node_seperation;
+  }
+
+  // Offset of control nodes adjacent to apex (m) which gives C2 smoothness at transition between swing curves, such
+  // that primary curve nodes are [p0, p1, p2, m + d, m] and secondary curve nodes are [m, m - d, q0, q1, q2]
+  Eigen::Vector3d d = (p[2] - q[0]) / 4.0;
+
+  // Third derivative of each curve is linear in time, with end values of the form (c + k * m)
+  Eigen::Vector3d c[4];
+  c[0] = d - 3.0 * p[2] + 3.0 * p[1] - p[0];
+  c[1] = -3.0 * d + 3.0 * p[2] - p[1];
+  c[2] = q[1] - 3.0 * q[0] - 3.0 * d;
+  c[3] = q[2] - 3.0 * q[1] + 3.0 * q[0] + d;
+  const double k[4] = { 1.0, -2.0, 2.0, -1.0 };
+
+  // Integrated squared jerk is proportional to |m - m*|^2 (plus constant), hence unconstrained optimum m* is found in
+  // closed form and constrained optimum is the euclidean projection of m* onto the feasible set
+  Eigen::Vector3d gradient = Eigen::Vector3d::Zero();
+  for (int i = 0; i < 4; i += 2)
+  {
+    gradient += 2.0 * k[i] * c[i] + k[i + 1] * c[i] + k[i] * c[i + 1] + 2.0 * k[i + 1] * c[i + 1];
+  }
+  Eigen::Vector3d apex = -gradient / 12.0;
+  double lateral_shift = walker_->getParameters().swing_width.current_value;
+  bool positive_y_axis = (Eigen::Vector3d::UnitY().dot(identity_tip_pose_.position_) > 0.0);
+  apex[1] += positive_y_axis ? lateral_shift : -lateral_shift;
+
+  // Clearance constraint: tip height about apex must exceed clearance envelope above interpolated tip height or known
+  // terrain height (queried in odom_ideal frame with lead to time of sample), defining a lower bound on apex height
+  Pose odometry = walker_->getOdometryIdeal();
+  double min_apex_height = -UNASSIGNED_VALUE;
+  const double clearance_samples[3] = { 0.75, 1.0, 0.25 };
+  for (int i = 0; i < 3; ++i)
+  {
+    bool primary = (i < 2);
+    double t = clearance_samples[i];
+    double s = 1.0 - t;
+    double w[5] = { s * s * s * s, 4.0 * s * s * s * t, 6.0 * s * s * t * t, 4.0 * s * t * t * t, t * t * t * t };
+    Eigen::Vector3d fixed_position;
+    double apex_weight;
+    if (primary)
+    {
+      fixed_position = w[0] * p[0] + w[1] * p[1] + w[2] * p[2] + w[3] * d;
+      apex_weight = w[3] + w[4];
+    }
+    else
+    {
+      fixed_position = -w[1] * d + w[2] * q[0] + w[3] * q[1] + w[4] * q[2];
+      apex_weight = w[0] + w[1];
+    }
+
+    double swing_progress = primary ? t / 2.0 : 0.5 + t / 2.0;
+    Eigen::Vector3d reference_position = swing_origin_tip_position_ * (1.0 - swing_progress) +
+                                         target_tip_pose_.position_ * swing_progress;
+    Eigen::Vector3d sample_position = fixed_position + apex_weight * apex;
+    Eigen::Vector3d lead = walker_->calculateOdometry(swing_progress * 2.0 * half_swing_time).position_;
+    Eigen::Vector3d mapped_position = odometry.transformVector(sample_position + lead);
+    mapped_position[2] = walker_->getTerrainMap()->getHeight(mapped_position);
+    double surface_height = reference_position[2];
+    if (mapped_position[2] != UNASSIGNED_VALUE)
+    {
+      surface_height = std::max(surface_height, (odometry.inverseTransformVector(mapped_position) - lead)[2]);
+    }
+    double envelope = swing_clearance_.norm() * 4.0 * swing_progress * (1.0 - swing_progress);
+    min_apex_height = std::max(min_apex_height, (surface_height + envelope - fixed_position[2]) / apex_weight);
+  }
+
+  // Speed constraint: tip speed is limited by the slowest joint acting about the longest lever arm to the tip
+  double max_tip_speed = UNASSIGNED_VALUE;
+  Eigen::Vector3d tip_position = leg_->getCurrentTipPose().position_;
+  for (JointContainer::iterator joint_it = leg_->getJointContainer()->begin();
+       joint_it != leg_->getJointContainer()->end(); ++joint_it)
+  {
+    std::shared_ptr<Joint> joint = joint_it->second;
+    double lever_arm = (tip_position - joint->getPoseRobotFrame().position_).norm();
+    if (lever_arm > 0.0 && joint->max_angular_speed_ > 0.0)
+    {
+      max_tip_speed = std::min(max_tip_speed, joint->max_angular_speed_ * lever_arm);
+    }
+  }
+
+  // Tip velocity at each sample time is of the form (c + k * m) / half_swing_time, defining a ball of feasible apexes
+  const int speed_sample_count = 6;
+  Eigen::Vector3d ball_centre[speed_sample_count];
+  double ball_radius[speed_sample_count];
+  for (int i = 0; i < speed_sample_count; ++i)
+  {
+    double t = 0.25 * (i % 3 + 1);
+    double s = 1.0 - t;
+    Eigen::Vector3d velocity_offset;
+    double velocity_gain;
+    if (i < 3)
+    {
+      velocity_offset = 4.0 * (s * s * s * (p[1] - p[0]) + 3.0 * s * s * t * (p[2] - p[1]) +
+                               3.0 * s * t * t * (d - p[2]) - t * t * t * d);
+      velocity_gain = 12.0 * s * t * t;
+    }
+    else
+    {
+      velocity_offset = 4.0 * (-s * s * s * d + 3.0 * s * s * t * (q[0] + d) +
+                               3.0 * s * t * t * (q[1] - q[0]) + t * t * t * (q[2] - q[1]));
+      velocity_gain = -12.0 * s * s * t;
+    }
+    ball_centre[i] = -velocity_offset / velocity_gain;
+    ball_radius[i] = max_tip_speed * half_swing_time / std::abs(velocity_gain);
+  }
+
+  // Project onto intersection of clearance half-space and speed balls via Dykstra's alternating projection
+  Eigen::Vector3d increments[speed_sample_count + 1];
+  for (int i = 0; i < speed_sample_count + 1; ++i)
+  {
+    increments[i] = Eigen::Vector3d::Zero();
+  }
+  Eigen::Vector3d projection = apex;
+  for (int iteration = 0; iteration < SWING_OPTIMISER_ITERATIONS; ++iteration)
+  {
+    for (int i = 0; i < speed_sample_count + 1; ++i)
+    {
+      Eigen::Vector3d point = projection + increments[i];
+      projection = point;
+      if (i == speed_sample_count)
+      {
+        projection[2] = std::max(projection[2], min_apex_height);
+      }
+      else if ((point - ball_centre[i]).norm() > ball_radius[i])
+      {
+        projection = ball_centre[i] + (point - ball_centre[i]).normalized() * ball_radius[i];
+      }
+      increments[i] = point - projection;
+    }
+  }
+
+  // Clearance takes priority over speed if constraints are infeasible
+  projection[2] = std::max(projection[2], min_apex_height);
+  for (int i = 0; i < speed_sample_count; ++i)
+  {
+    if ((projection - ball_centre[i]).norm() > ball_radius[i] + SWING_OPTIMISER_TOLERANCE)
+    {
+      ROS_WARN_THROTTLE(THROTTLE_PERIOD, "\n[SHC] Optimised swing trajectory of leg %s exceeds joint speed limits. "
+                                         "Consider reducing step frequency or swing height.\n",
+                        leg_->getIDName().c_str());
+      break;
+    }
+  }
+  swing_apex_position_ = projection;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
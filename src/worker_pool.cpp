@@ -0,0 +1,141 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syropod_highlevel_controller/worker_pool.h"
+
+#include <pthread.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+WorkerPool::WorkerPool(const int &thread_count, const int &excluded_core)
+    : next_task_(0)
+{
+  // Workers inherit scheduling of the calling thread, which blocks on them each cycle
+  int policy = SCHED_OTHER;
+  sched_param scheduling_parameters;
+  scheduling_parameters.sched_priority = 0;
+  pthread_getschedparam(pthread_self(), &policy, &scheduling_parameters);
+
+  // Distribute workers over every core except that of the calling thread (the first core if it is unpinned)
+  int core_count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  int reserved_core = (excluded_core >= 0 && excluded_core < core_count ? excluded_core : 0);
+  std::vector<int> cores;
+  for (int core = 0; core < core_count; ++core)
+  {
+    if (core != reserved_core || core_count == 1)
+    {
+      cores.push_back(core);
+    }
+  }
+
+  for (int i = 0; i < thread_count; ++i)
+  {
+    int core = cores[i % cores.size()];
+    threads_.push_back(std::thread(&WorkerPool::work, this, core, policy, scheduling_parameters.sched_priority));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+WorkerPool::~WorkerPool(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  start_condition_.notify_all();
+  for (std::thread &thread : threads_)
+  {
+    thread.join();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::execute(const int &task_count, const std::function<void(int)> &task)
+{
+  // Execute serially if no workers are available or there is nothing to share
+  if (threads_.empty() || task_count < 2)
+  {
+    for (int i = 0; i < task_count; ++i)
+    {
+      task(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    task_count_ = task_count;
+    next_task_ = 0;
+    active_workers_ = static_cast<int>(threads_.size());
+    generation_++;
+  }
+  start_condition_.notify_all();
+
+  executeTasks();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  finish_condition_.wait(lock, [this] { return active_workers_ == 0; });
+  task_ = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::work(const int core, const int policy, const int priority)
+{
+  sched_param scheduling_parameters;
+  scheduling_parameters.sched_priority = priority;
+  if (pthread_setschedparam(pthread_self(), policy, &scheduling_parameters) != 0)
+  {
+    ROS_WARN("\n[SHC] Unable to set scheduling priority %d for worker thread.\n", priority);
+  }
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(core, &cpu_set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set) != 0)
+  {
+    ROS_WARN("\n[SHC] Unable to pin worker thread to CPU core %d.\n", core);
+  }
+
+  unsigned long generation = 0;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_condition_.wait(lock, [&] { return shutdown_ || generation_ != generation; });
+      if (shutdown_)
+      {
+        return;
+      }
+      generation = generation_;
+    }
+
+    executeTasks();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--active_workers_ == 0)
+    {
+      finish_condition_.notify_one();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void WorkerPool::executeTasks(void)
+{
+  for (int i = next_task_++; i < task_count_; i = next_task_++)
+  {
+    (*task_)(i);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,252 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2019
+// Commonwealth Scientific and Industrial Research Organisation (CSIRO)
+// ABN 41 687 119 230
+//
+// Author: Fletcher Talbot
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "syropod_highlevel_controller/state_controller.h"
+#include "syropod_highlevel_controller/yaml_parameters.h"
+
+#include <gtest/gtest.h>
+
+#define MAX_TEST_CYCLES 100000   ///< Max cycles allowed for any awaited condition before a test fails
+#define TOUCHDOWN_TOLERANCE 0.01 ///< Max error of a tip position relative to a planned footstep (metres)
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// Test fixture which runs the state controller headless (without a ros master) from the package config files, with
+/// perfect joint feedback, and transitions the robot to the running state.
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class WalkControllerTest : public ::testing::Test
+{
+protected:
+  void SetUp(void) override
+  {
+    ASSERT_TRUE(loadConfigFiles({std::string(SHC_CONFIG_DIRECTORY) + "/default.yaml",
+                                 std::string(SHC_CONFIG_DIRECTORY) + "/gait.yaml",
+                                 std::string(SHC_CONFIG_DIRECTORY) + "/auto_pose.yaml"}));
+    getLocalParameters()["/syropod/parameters/debug_rviz"] = false;
+    getLocalParameters()["/syropod/parameters/odometry_fusion"] = false;
+
+    state_ = std::make_shared<StateController>();
+    state_->init();
+    state_->initModel(true);
+    ASSERT_FALSE(state_->hasFatalError());
+    model_ = state_->getModel();
+    walker_ = state_->getWalker();
+
+    std_msgs::Int8 system_state;
+    system_state.data = OPERATIONAL;
+    state_->systemStateCallback(system_state);
+
+    // Transition robot to running state, as if start button were held
+    std_msgs::Int8 robot_state;
+    robot_state.data = RUNNING;
+    int cycles = 0;
+    while (state_->getRobotState() != RUNNING && cycles++ < MAX_TEST_CYCLES)
+    {
+      state_->robotStateCallback(robot_state);
+      iterate();
+    }
+    ASSERT_EQ(state_->getRobotState(), RUNNING);
+  }
+
+  /// Runs a single control loop cycle, then sets the current state of every joint to the desired state.
+  void iterate(void)
+  {
+    state_->loop();
+    for (LegContainer::iterator leg_it = model_->getLegContainer()->begin();
+         leg_it != model_->getLegContainer()->end(); ++leg_it)
+    {
+      JointContainer::iterator joint_it;
+      for (joint_it = leg_it->second->getJointContainer()->begin();
+           joint_it != leg_it->second->getJointContainer()->end(); ++joint_it)
+      {
+        std::shared_ptr<Joint> joint = joint_it->second;
+        joint->current_position_ = joint->desired_position_;
+        joint->current_velocity_ = joint->desired_velocity_;
+        joint->current_effort_ = joint->desired_effort_;
+      }
+    }
+  }
+
+  /// Sets the body velocity input.
+  /// @param[in] linear_x Normalised linear body velocity input along the x axis
+  /// @param[in] angular_z Normalised angular body velocity input about the z axis
+  void setVelocityInput(const double &linear_x, const double &angular_z)
+  {
+    geometry_msgs::Twist velocity;
+    velocity.linear.x = linear_x;
+    velocity.angular.z = angular_z;
+    state_->bodyVelocityInputCallback(velocity);
+  }
+
+  /// Iterates until the walker's desired velocity stops changing (i.e. acceleration to the input is complete).
+  void iterateUntilSteadyVelocity(void)
+  {
+    Eigen::Vector2d linear_velocity = walker_->getDesiredLinearVelocity();
+    double angular_velocity = walker_->getDesiredAngularVelocity();
+    int cycles = 0;
+    do
+    {
+      linear_velocity = walker_->getDesiredLinearVelocity();
+      angular_velocity = walker_->getDesiredAngularVelocity();
+      iterate();
+    } while ((walker_->getWalkState() != MOVING || linear_velocity != walker_->getDesiredLinearVelocity() ||
+              angular_velocity != walker_->getDesiredAngularVelocity()) && cycles++ < MAX_TEST_CYCLES);
+    ASSERT_EQ(walker_->getWalkState(), MOVING);
+  }
+
+  /// Iterates until the walker reaches the given walk state, recording each change of walk state.
+  /// @param[in] walk_state The walk state to iterate until
+  /// @param[in,out] walk_states The sequence of walk states, appended with each change of walk state
+  void iterateUntilWalkState(const WalkState &walk_state, std::vector<WalkState> *walk_states)
+  {
+    int cycles = 0;
+    while (walker_->getWalkState() != walk_state && cycles++ < MAX_TEST_CYCLES)
+    {
+      iterate();
+      if (walk_states->empty() || walk_states->back() != walker_->getWalkState())
+      {
+        walk_states->push_back(walker_->getWalkState());
+      }
+    }
+  }
+
+  std::shared_ptr<StateController> state_;  ///< The state controller under test
+  std::shared_ptr<Model> model_;            ///< The robot model of the state controller
+  std::shared_ptr<WalkController> walker_;  ///< The walk controller of the state controller
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(WalkControllerTest, PlannedTargetPredictedWhilstTurning)
+{
+  setVelocityInput(0.5, 0.5);
+  iterateUntilSteadyVelocity();
+  ASSERT_NE(walker_->getDesiredAngularVelocity(), 0.0);
+
+  // Wait until the leg is in the back half of stance, after the external target reset at stance start
+  std::shared_ptr<LegStepper> leg_stepper = model_->getLegByIDNumber(0)->getLegStepper();
+  int cycles = 0;
+  while ((leg_stepper->getStepState() != STANCE || leg_stepper->getStanceProgress() < 0.5) &&
+         cycles++ < MAX_TEST_CYCLES)
+  {
+    iterate();
+  }
+  ASSERT_EQ(leg_stepper->getStepState(), STANCE);
+
+  // Plan footstep (held in odom_ideal frame) offset from the current nominal target of the leg
+  Eigen::Vector3d nominal_target = leg_stepper->getDefaultTipPose().position_ + 0.5 * leg_stepper->getStrideVector();
+  Eigen::Vector3d offset(0.02, 0.02, 0.0);
+  Eigen::Vector3d footstep = walker_->getOdometryIdeal().transformVector(nominal_target + offset);
+  ExternalTarget planned_target;
+  planned_target.pose_ = Pose(footstep, Eigen::Quaterniond::Identity());
+  planned_target.swing_clearance_ = walker_->getStepClearance();
+  planned_target.frame_id_ = ODOM_IDEAL_FRAME_ID;
+  planned_target.transform_ = Pose::Identity();
+  planned_target.defined_ = true;
+  planned_target.planned_ = true;
+  leg_stepper->setExternalTarget(planned_target);
+
+  // Iterate through the following swing period until touchdown, saving the target set in the 1st swing iteration
+  Eigen::Vector3d initial_target;
+  Pose odometry;
+  int swing_iteration = 0;
+  cycles = 0;
+  while (!(swing_iteration > 0 && leg_stepper->getStepState() == STANCE) && cycles++ < MAX_TEST_CYCLES)
+  {
+    bool swinging = (leg_stepper->getStepState() == SWING);
+    odometry = walker_->getOdometryIdeal();
+    iterate();
+    if (swinging && ++swing_iteration == 1)
+    {
+      initial_target = leg_stepper->getTargetTipPose().position_;
+    }
+  }
+  ASSERT_GT(swing_iteration, 1);
+
+  // Target in the 1st swing iteration must predict the footstep position relative to the body at touchdown, which
+  // requires the rotation of the body over the swing period (in addition to translation) to be accounted for
+  Eigen::Vector3d predicted_footstep = odometry.transformVector(initial_target);
+  EXPECT_NEAR(predicted_footstep[0], footstep[0], TOUCHDOWN_TOLERANCE);
+  EXPECT_NEAR(predicted_footstep[1], footstep[1], TOUCHDOWN_TOLERANCE);
+
+  // Touchdown position must match the planned footstep
+  Eigen::Vector3d touchdown = odometry.transformVector(leg_stepper->getCurrentTipPose().position_);
+  EXPECT_NEAR(touchdown[0], footstep[0], TOUCHDOWN_TOLERANCE);
+  EXPECT_NEAR(touchdown[1], footstep[1], TOUCHDOWN_TOLERANCE);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(WalkControllerTest, MakeReachableLimitsToWorkplane)
+{
+  std::shared_ptr<Leg> leg = model_->getLegByIDNumber(0);
+  Eigen::Vector3d identity_tip_position = leg->getLegStepper()->getIdentityTipPose().position_;
+
+  // Candidate near the identity tip position is reachable and left unchanged
+  Eigen::Vector3d reachable = identity_tip_position + Eigen::Vector3d(0.01, 0.01, 0.0);
+  EXPECT_TRUE(leg->makeReachable(reachable).isApprox(reachable));
+
+  // Candidate beyond the workspace is moved back to the workplane limit along its bearing from the identity tip
+  Eigen::Vector3d offset(-MAX_WORKSPACE_RADIUS, 2.0 * MAX_WORKSPACE_RADIUS, 0.0);
+  Eigen::Vector3d unreachable = identity_tip_position + offset;
+  Eigen::Vector3d reachable_offset = leg->makeReachable(unreachable) - identity_tip_position;
+  Eigen::Vector2d planar_offset(reachable_offset[0], reachable_offset[1]);
+  EXPECT_GT(planar_offset.norm(), 0.0);
+  EXPECT_LT(planar_offset.norm(), Eigen::Vector2d(offset[0], offset[1]).norm());
+  EXPECT_NEAR(atan2(planar_offset[1], planar_offset[0]), atan2(offset[1], offset[0]), 1e-3);
+
+  // Result lies within the workplane so is itself reachable
+  Eigen::Vector3d limited = identity_tip_position + reachable_offset;
+  EXPECT_LT((leg->makeReachable(limited) - limited).norm(), IK_TOLERANCE);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(WalkControllerTest, WalkStateTransitions)
+{
+  std::vector<WalkState> walk_states = {walker_->getWalkState()};
+  ASSERT_EQ(walk_states.front(), STOPPED);
+
+  setVelocityInput(0.5, 0.0);
+  iterateUntilWalkState(MOVING, &walk_states);
+  setVelocityInput(0.0, 0.0);
+  iterateUntilWalkState(STOPPED, &walk_states);
+
+  std::vector<WalkState> expected_walk_states = {STOPPED, STARTING, MOVING, STOPPING, STOPPED};
+  EXPECT_EQ(walk_states, expected_walk_states);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_F(WalkControllerTest, WalkStateStartingCompletesBeforeStopping)
+{
+  std::vector<WalkState> walk_states = {walker_->getWalkState()};
+
+  // Velocity input removed whilst starting must not interrupt the first step of each leg
+  setVelocityInput(0.5, 0.0);
+  iterateUntilWalkState(STARTING, &walk_states);
+  setVelocityInput(0.0, 0.0);
+  iterate();
+  EXPECT_EQ(walker_->getWalkState(), STARTING);
+  iterateUntilWalkState(STOPPED, &walk_states);
+
+  std::vector<WalkState> expected_walk_states = {STOPPED, STARTING, MOVING, STOPPING, STOPPED};
+  EXPECT_EQ(walk_states, expected_walk_states);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+  ros::Time::init();
+  ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Error);
+  ros::console::notifyLoggerLevelsChanged();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////